@@ -11,6 +11,7 @@ if(${BLAS_VERSION} MATCHES "winmkl")
     set(BLAS_HEADER_FILE "mkl_cblas.h")
     set(BLAS_INCLUDE_DIRS ${INTEL_ROOT}/mkl/include)
     set(BLAS_LIBRARIES ${INTEL_ROOT}/mkl/lib/intel64/mkl_rt.lib)
+    set(BLAS_THREADING_DEFINITION BLAS_MKL_THREADING)
     set(USE_BLAS TRUE)
 endif()
 
@@ -26,6 +27,7 @@ if(${BLAS_VERSION} MATCHES "winopenblas")
         ${OPENBLAS_ROOT}
         ${OPENBLAS_ROOT}/build)
     set(BLAS_LIBRARIES ${OPENBLAS_ROOT}/build/lib/Release/openblas.lib)
+    set(BLAS_THREADING_DEFINITION BLAS_OPENBLAS_THREADING)
     add_definitions(-DC_MSVC)
     set(USE_BLAS TRUE)
 endif()
@@ -41,6 +43,7 @@ if(${BLAS_VERSION} MATCHES "winopenblas219")
     set(BLAS_HEADER_FILE "cblas.h")
     set(BLAS_INCLUDE_DIRS ${OPENBLAS_ROOT}/include)
     set(BLAS_LIBRARIES ${OPENBLAS_ROOT}/lib/libopenblas.dll.a)
+    set(BLAS_THREADING_DEFINITION BLAS_OPENBLAS_THREADING)
     add_definitions(-DC_MSVC)
     set(USE_BLAS TRUE)
 endif()
@@ -49,5 +52,6 @@ if(${BLAS_VERSION} MATCHES "ubuntuopenblas")
     set(BLAS_HEADER_FILE "cblas.h")
     set(BLAS_INCLUDE_DIRS /usr/include/openblas)
     set(BLAS_LIBRARIES /usr/lib/libopenblas.so)
+    set(BLAS_THREADING_DEFINITION BLAS_OPENBLAS_THREADING)
     set(USE_BLAS TRUE)
 endif()
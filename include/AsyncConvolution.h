@@ -0,0 +1,130 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     AsyncConvolution.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ThreadPool.h"
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+
+//
+// Asynchronous versions of the Convolution overloads, which run on the shared thread pool. Each function takes the same arguments
+// as the corresponding Convolution overload (starting with its ConvProperties), copies them, and returns immediately. The tensors
+// and temporary space that the arguments point to must remain valid, and must not be used by other code, until the convolution
+// completes. Parallel loops inside the convolution (such as a parallel unroll) share the same pool. BLAS is restricted to a
+// single thread while a submitted convolution runs, as in RunConcurrently, since several of them usually run at once and each
+// would otherwise start as many BLAS threads as there are cores.
+//
+
+// Submits a convolution and returns a future that becomes ready when it completes, and rethrows any exception it threw
+template <typename... ArgumentTypes>
+std::future<void> ConvolutionAsync(ArgumentTypes... arguments)
+{
+    auto promise = std::make_shared<std::promise<void>>();
+    auto future = promise->get_future();
+    ThreadPool::GetShared().Submit([promise, arguments...]()
+    {
+        try
+        {
+            {
+                SingleThreadedBlasScope blasScope;
+                Convolution(arguments...);
+            }
+            promise->set_value();
+        }
+        catch(...)
+        {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
+
+// Submits a convolution, and calls callback(error) on the pool thread that ran it when it completes, where error is an
+// std::exception_ptr that is null if the convolution succeeded
+template <typename CallbackType, typename... ArgumentTypes>
+void ConvolutionAsyncWithCallback(CallbackType callback, ArgumentTypes... arguments)
+{
+    ThreadPool::GetShared().Submit([callback, arguments...]()
+    {
+        std::exception_ptr error;
+        try
+        {
+            SingleThreadedBlasScope blasScope;
+            Convolution(arguments...);
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+        callback(error);
+    });
+}
+
+// An awaitable convolution, for use with co_await in a C++20 coroutine: the coroutine is suspended while the convolution runs
+// on the shared thread pool, and resumes on the pool thread that ran it. The coroutine handle type is a template parameter, so
+// this header compiles as C++14 without <coroutine>.
+template <typename... ArgumentTypes>
+class ConvolutionAwaitable
+{
+public:
+    ConvolutionAwaitable(ArgumentTypes... arguments) : _state(std::make_shared<State>(arguments...)) {}
+
+    // the convolution has not started, so the coroutine always suspends
+    bool await_ready() const noexcept { return false; }
+
+    template <typename CoroutineHandleType>
+    void await_suspend(CoroutineHandleType handle)
+    {
+        auto state = _state;
+        ThreadPool::GetShared().Submit([state, handle]() mutable
+        {
+            try
+            {
+                SingleThreadedBlasScope blasScope;
+                state->Run();
+            }
+            catch(...)
+            {
+                state->error = std::current_exception();
+            }
+            handle.resume();
+        });
+    }
+
+    // rethrows any exception thrown by the convolution
+    void await_resume() const
+    {
+        if(_state->error)
+        {
+            std::rethrow_exception(_state->error);
+        }
+    }
+
+private:
+    struct State
+    {
+        State(ArgumentTypes... arguments) : run([arguments...]() { Convolution(arguments...); }) {}
+        void Run() { run(); }
+
+        std::function<void()> run;
+        std::exception_ptr error;
+    };
+
+    std::shared_ptr<State> _state;
+};
+
+// Creates an awaitable convolution, as in co_await AwaitConvolution(properties, W, X, Y, ...)
+template <typename... ArgumentTypes>
+ConvolutionAwaitable<ArgumentTypes...> AwaitConvolution(ArgumentTypes... arguments)
+{
+    return ConvolutionAwaitable<ArgumentTypes...>(arguments...);
+}
@@ -0,0 +1,41 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     BackgroundIoThread.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+
+// A dedicated thread that runs blocking jobs, such as file reads and writes, one at a time in the order they are submitted, so
+// that they overlap with computation on the calling thread and the shared thread pool without occupying a pool thread.
+class BackgroundIoThread
+{
+public:
+    BackgroundIoThread();
+
+    // runs the jobs that are still queued, and then stops the thread
+    ~BackgroundIoThread();
+
+    BackgroundIoThread(const BackgroundIoThread&) = delete;
+    BackgroundIoThread& operator=(const BackgroundIoThread&) = delete;
+
+    // queues a job, and returns a future that becomes ready when it completes, and rethrows any exception it threw
+    std::future<void> Submit(std::function<void()> job);
+
+private:
+    void Loop();
+
+    std::deque<std::packaged_task<void()>> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _jobAdded;
+    bool _isStopping = false;
+    std::thread _thread;
+};
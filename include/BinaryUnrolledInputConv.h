@@ -0,0 +1,69 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     BinaryUnrolledInputConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BitPacking.h"
+#include "BlasHelpers.h"
+#include "ConvProperties.h"
+#include "UnrolledInputConv_rI.h"
+
+#include <cstdint>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * binary input and filters (-1 or +1), bit-packed along the channel dimension, with 32-bit integer output
+// * unrolled input
+// * filters in filter-major order
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * GetPackedSize(wChls) * yRows * yCols) 64-bit words
+//
+// W: 4-dimensional packed weights tensor in filter-major order, with GetPackedSize(wChls) words per filter position
+// X: 3-dimensional packed input tensor in row-major order, with GetPackedSize(wChls) words per input pixel
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W (before packing)
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// space: pointer to temporary space of size at least (wRows * wCols * GetPackedSize(wChls) * yRows * yCols)
+inline void Convolution(ConvProperties<BitPackedBinary, FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>,
+    const uint64_t* W,
+    const uint64_t* X,
+    int32_t* Y,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    uint64_t* space)
+{
+    // the packed tensors have the same layout as unpacked tensors with GetPackedSize(wChls) channels
+    int packedChls = GetPackedSize(wChls);
+
+    // use temp space to store the unrolled input matrix U in row-major order
+    int uRows = yRows * yCols;
+    int uCols = wRows * wCols * packedChls;
+    uint64_t* U = space;
+
+    // unroll the row-major input, which moves 1/32 of the bytes moved by the float unroll
+    RowMajInputUnroll(X, U, wRows, wCols, packedChls, vStride, hStride, yRows, yCols, uRows, uCols);
+
+    // reshape the filters tensor W into a column-major matrix V
+    int vCols = wCount;
+    const uint64_t* V = W;
+
+    // XNOR-popcount matrix-matrix multiply
+    Gemm(RowMaj, ColMaj, RowMaj, uRows, vCols, uCols, wRows * wCols * wChls, U, V, Y);
+}
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     BitPacking.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+
+//
+// Bit-packed binary tensors. Each element is binarized to -1 or +1 and stored as a single bit (a set bit represents +1), so a packed
+// tensor is 32 times smaller than a float tensor. Tensors are packed along their minor dimension (channels, for row-major inputs and
+// filter-major filters), with each group of elements padded to a whole number of 64-bit words. The padding bits are clear in both the
+// input and the filters, so they never contribute to an XNOR-popcount dot product.
+//
+
+// returns the number of 64-bit words needed to pack a group of size elements
+inline int GetPackedSize(int size)
+{
+    return (size + 63) / 64;
+}
+
+// binarizes a single value to -1 or +1, where zero (and therefore zero-padding) maps to +1
+template <typename ElementType>
+ElementType Binarize(ElementType value)
+{
+    return value >= 0 ? ElementType(1) : ElementType(-1);
+}
+
+// Packs count groups of size contiguous elements into count groups of GetPackedSize(size) words
+// source: pointer to count * size elements
+// target: pointer to count * GetPackedSize(size) words
+// count: number of groups
+// size: number of elements in each group
+template <typename ElementType>
+void PackBits(const ElementType* source, uint64_t* target, int count, int size)
+{
+    int packedSize = GetPackedSize(size);
+    for(int group = 0; group < count; ++group)
+    {
+        for(int word = 0; word < packedSize; ++word)
+        {
+            uint64_t bits = 0;
+            for(int bit = 0; bit < 64 && word * 64 + bit < size; ++bit)
+            {
+                if(source[word * 64 + bit] >= 0)
+                {
+                    bits |= (uint64_t)1 << bit;
+                }
+            }
+            target[word] = bits;
+        }
+        source += size;
+        target += packedSize;
+    }
+}
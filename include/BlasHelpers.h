@@ -9,13 +9,47 @@
 
 #include "Tensor.h"
 
+#include <cstdint>
+
 // GEMM overloads
 void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int n, int k, float alpha, const float* A, int lda, const float* B, int ldb, float beta, float* C, int ldc);
 void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, float alpha, const float* A, int lda, const float* B, int ldb, float beta, float* C, int ldc);
 void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, float alpha, const float* A, const float* B, float beta, float* C);
+void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int n, int k, double alpha, const double* A, int lda, const double* B, int ldb, double beta, double* C, int ldc);
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, double alpha, const double* A, int lda, const double* B, int ldb, double beta, double* C, int ldc);
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, double alpha, const double* A, const double* B, double beta, double* C);
+
+// batched GEMM of small row-major matrices with a shared n and k, where the multiplications are performed in order and may accumulate into the same C (C[i] = A[i] * B[i] + beta[i] * C[i])
+void GemmBatch(int batchSize, const int* m, int n, int k, const float* const* A, const float* const* B, const float* beta, float* const* C);
+void GemmBatch(int batchSize, const int* m, int n, int k, const double* const* A, const double* const* B, const double* beta, double* const* C);
+
+// integer GEMM, with 8-bit unsigned A, 8-bit signed B, and 32-bit accumulation (C = A * B)
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, const uint8_t* A, const int8_t* B, int32_t* C);
+
+// binary GEMM, with bit-packed A and B whose bits represent -1 (clear) or +1 (set) and 32-bit output (C = A * B); k is the number of 64-bit words and kBits is the number of valid bits in each row of A and column of B
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, int kBits, const uint64_t* A, const uint64_t* B, int32_t* C);
 
 // AXPY 
 void Axpy(int n, float alpha, const float* X, int incX, float* Y, int incY);
+void Axpy(int n, double alpha, const double* X, int incX, double* Y, int incY);
 
 // COPY
 void Copy(int n, const float* X, int incX, float* Y, int incY);
+void Copy(int n, const double* X, int incX, double* Y, int incY);
+
+// number of threads used by each BLAS call (always 1 if the BLAS configuration does not support setting it)
+int GetBlasThreadCount();
+void SetBlasThreadCount(int threadCount);
+
+// Restricts BLAS to a single thread while at least one object of this class exists, for code that makes BLAS calls from
+// several threads of the thread pool at once and would otherwise oversubscribe the cores. Objects may be nested and may exist
+// on several threads at once: the first one saves the BLAS thread count and the last one restores it.
+class SingleThreadedBlasScope
+{
+public:
+    SingleThreadedBlasScope();
+    ~SingleThreadedBlasScope();
+
+    SingleThreadedBlasScope(const SingleThreadedBlasScope&) = delete;
+    SingleThreadedBlasScope& operator=(const SingleThreadedBlasScope&) = delete;
+};
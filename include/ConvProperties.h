@@ -10,23 +10,36 @@
 #include <tuple>
 
 // properties used to specialize the implementation of convolution 
+struct BitPackedBinary{};       // input and filters are binary (-1 or +1) and bit-packed along the channel dimension, with 32-bit integer output
 struct ChannelMajorInput{};     // input is provided in channel major tensor order
 struct ChannelMajorOutput{};    // output is generated in channel major tensor order
 struct ExplicitInputPadding{};  // input tensor includes explicit zero-padding
 struct ExplicitOutputPadding{}; // output tensor includes explicit zero-padding
 struct FilterMajorFilters{};    // filter tensor is given in filter, row, column, channel major-to-minor order
+struct FusedLayers{};           // a chain of layers is computed depth-first in bands of output rows, keeping intermediate outputs in cache
 struct ImplicitInputPadding{};  // input should be processed with implicit zero-padding
+struct IncrementalUpdate{};     // only the output affected by changed rectangles of the input is recomputed, in place
+struct JitCompiledUnroll{};     // input is unrolled by machine code generated at runtime for the specific shape
 struct OddField{};              // odd receptive field size - number of filter rows must be odd, number of filter columns must be odd
+struct OutOfCore{};             // input and output are files that are processed in tiles, with reads and writes overlapped with computation
 struct PartiallyUnrolledInput{};// input is partially unrolled piece by piece
+struct PipelinedUnroll{};       // input is unrolled in chunks of rows, overlapped with the matrix multiplication of completed chunks
+struct QuantizedInt8{};         // input, filters and output are quantized to 8-bit integers, with 32-bit integer accumulation
+struct ReducedPrecisionStorage{};// input and output are stored in a 16-bit floating point type, computation is done in float
 struct RowMajorFilters{};       // filter tensor is given in row, column, channel, filter major-to-minor order
 struct RowMajorInput{};         // input is provided in row major tensor order
 struct RowMajorOutput{};        // output is provided in row major tensor order
+struct SeparableFilters{};      // filters are given as sums of outer products of vertical and horizontal 1D filters
+struct SmallChannelCount{};     // number of input channels must be between 1 and 4
+struct SparseFilters{};         // filters are given as a sparse matrix, in compressed sparse row or block-sparse format
+struct SpatialTiling{};         // output rows are split into bands that are computed in parallel, each with its own temporary space
 struct ThreeByThreeField{};     // number of filter rows and columns must equal 3
 struct UnitHorizontalStride{};  // horizontal stride must equal 1
 struct UnitVerticalStride{};    // vertical stride must equal 1
 struct UnrolledInput{};         // input is unrolled 
 struct UnrolledOutput{};        // output is unrolled
 struct VirtuallyUnrolledInput{};// input is virtually unrolled piece by piece
+struct ZeroSkippingInput{};     // input regions that are entirely zero are detected during unrolling and skipped
 
 // a convenient way of collecting an arbitrary number of properties in one type
 template<typename ... T>
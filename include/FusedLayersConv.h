@@ -0,0 +1,431 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     FusedLayersConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ConvProperties.h"
+#include "ThreadPool.h"
+#include "UnrolledInputConv_rI.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+// default size in bytes of the working set of one band of a fused chain, chosen to fit in a typical per-core L2 cache
+const int fusedLayersCacheSize = 1 << 18;
+
+// size in bytes of the part of the cache that holds the intermediate outputs of a band; the rest of the cache holds the chunks of
+// unrolled input
+const int fusedIntermediateCacheSize = fusedLayersCacheSize / 2;
+
+// one layer in a chain of convolutions, where the output of each layer is the input of the next layer, without padding (the
+// input of the chain includes any padding that the first layer needs, and each layer's output shrinks accordingly)
+template <typename ElementType>
+struct ConvLayer
+{
+    const ElementType* W; // 4-dimensional weights tensor in filter-major order
+    int wCount;           // number of filters, which is the number of channels of the layer's output
+    int wRows;
+    int wCols;
+    int wChls;            // must equal the number of channels of the layer's input
+    int vStride;
+    int hStride;
+};
+
+// the input and output shape of one layer in a chain
+struct ConvLayerShape
+{
+    int xRows;
+    int xCols;
+    int xChls;
+    int yRows;
+    int yCols;
+    int yChls;
+};
+
+// Gets the input and output shape of each layer in a chain, given the shape of the input of the first layer. Throws
+// std::invalid_argument if the filters and strides of a layer do not cover its input exactly, since the unroll derives the
+// number of input columns from the output shape, (yCols - 1) * hStride + wCols.
+template <typename ElementType>
+std::vector<ConvLayerShape> GetChainShapes(const std::vector<ConvLayer<ElementType>>& layers, int xRows, int xCols)
+{
+    std::vector<ConvLayerShape> shapes;
+    for(const auto& layer : layers)
+    {
+        if(xRows < layer.wRows || xCols < layer.wCols || (xRows - layer.wRows) % layer.vStride != 0 || (xCols - layer.wCols) % layer.hStride != 0)
+        {
+            throw std::invalid_argument("layer filters and strides do not cover the layer input exactly");
+        }
+
+        int yRows = (xRows - layer.wRows) / layer.vStride + 1;
+        int yCols = (xCols - layer.wCols) / layer.hStride + 1;
+        shapes.push_back({ xRows, xCols, layer.wChls, yRows, yCols, layer.wCount });
+        xRows = yRows;
+        xCols = yCols;
+    }
+    return shapes;
+}
+
+// Gets the number of output rows that each layer computes for a band of bandRows rows of the last layer's output: each layer
+// needs (rows - 1) * vStride + wRows rows of the previous layer's output, including the halo rows shared with the next band
+template <typename ElementType>
+std::vector<int> GetFusedLayerRows(const std::vector<ConvLayer<ElementType>>& layers, int bandRows)
+{
+    std::vector<int> layerRows(layers.size());
+    int rows = bandRows;
+    for(int l = (int)layers.size() - 1; l >= 0; --l)
+    {
+        layerRows[l] = rows;
+        rows = (rows - 1) * layers[l].vStride + layers[l].wRows;
+    }
+    return layerRows;
+}
+
+// Gets the size of each of the two buffers that hold a band's intermediate outputs, which alternate between layers
+template <typename ElementType>
+int GetFusedIntermediateSize(const std::vector<ConvLayer<ElementType>>& layers, const std::vector<ConvLayerShape>& shapes, int bandRows)
+{
+    auto layerRows = GetFusedLayerRows(layers, bandRows);
+    int intermediateSize = 0;
+    for(size_t l = 0; l + 1 < layers.size(); ++l)
+    {
+        intermediateSize = std::max(intermediateSize, layerRows[l] * shapes[l].yCols * shapes[l].yChls);
+    }
+    return intermediateSize;
+}
+
+// Gets the number of output rows of each layer that are unrolled and multiplied at a time within a band: as many as fit in the
+// part of the cache that the band's intermediate outputs leave, and at least one
+template <typename ElementType>
+std::vector<int> GetFusedChunkRows(const std::vector<ConvLayer<ElementType>>& layers, const std::vector<ConvLayerShape>& shapes, int bandRows)
+{
+    auto layerRows = GetFusedLayerRows(layers, bandRows);
+    long long intermediateBytes = 2LL * GetFusedIntermediateSize(layers, shapes, bandRows) * (long long)sizeof(ElementType);
+    long long unrolledBytes = std::max((long long)fusedLayersCacheSize - intermediateBytes, 0LL);
+    std::vector<int> chunkRows(layers.size());
+    for(size_t l = 0; l < layers.size(); ++l)
+    {
+        const auto& layer = layers[l];
+        long long rowBytes = (long long)shapes[l].yCols * layer.wRows * layer.wCols * layer.wChls * (long long)sizeof(ElementType);
+        chunkRows[l] = (int)std::max(1LL, std::min((long long)layerRows[l], unrolledBytes / rowBytes));
+    }
+    return chunkRows;
+}
+
+// Gets the size of the temporary space used by one band: two buffers for the band's intermediate outputs, which alternate between
+// layers, and the largest chunk of unrolled input (see GetFusedChunkRows)
+template <typename ElementType>
+int GetFusedBandSpaceSize(const std::vector<ConvLayer<ElementType>>& layers, const std::vector<ConvLayerShape>& shapes, int bandRows)
+{
+    auto chunkRows = GetFusedChunkRows(layers, shapes, bandRows);
+    int unrolledSize = 0;
+    for(size_t l = 0; l < layers.size(); ++l)
+    {
+        const auto& layer = layers[l];
+        unrolledSize = std::max(unrolledSize, chunkRows[l] * shapes[l].yCols * layer.wRows * layer.wCols * layer.wChls);
+    }
+    return 2 * GetFusedIntermediateSize(layers, shapes, bandRows) + unrolledSize;
+}
+
+// Gets the size of the temporary space used to run a chain one layer at a time: two buffers for the full intermediate outputs,
+// which alternate between layers, and the unrolled input of the largest layer
+template <typename ElementType>
+int GetLayerByLayerSpaceSize(const std::vector<ConvLayer<ElementType>>& layers, int xRows, int xCols)
+{
+    auto shapes = GetChainShapes(layers, xRows, xCols);
+    int intermediateSize = 0;
+    int unrolledSize = 0;
+    for(size_t l = 0; l < layers.size(); ++l)
+    {
+        const auto& layer = layers[l];
+        if(l + 1 < layers.size())
+        {
+            intermediateSize = std::max(intermediateSize, shapes[l].yRows * shapes[l].yCols * shapes[l].yChls);
+        }
+        unrolledSize = std::max(unrolledSize, shapes[l].yRows * shapes[l].yCols * layer.wRows * layer.wCols * layer.wChls);
+    }
+    return 2 * intermediateSize + unrolledSize;
+}
+
+// Gets the fraction of the intermediate outputs that are computed more than once, because the halo rows that a band shares with
+// the next band are recomputed by both bands
+template <typename ElementType>
+double GetFusedRecomputedFraction(const std::vector<ConvLayer<ElementType>>& layers, const std::vector<ConvLayerShape>& shapes, int bandRows)
+{
+    int yRows = shapes.back().yRows;
+    double computed = 0;
+    double needed = 0;
+    for(int bandBegin = 0; bandBegin < yRows; bandBegin += bandRows)
+    {
+        auto layerRows = GetFusedLayerRows(layers, std::min(bandRows, yRows - bandBegin));
+        for(size_t l = 0; l + 1 < layers.size(); ++l)
+        {
+            computed += (double)layerRows[l] * shapes[l].yCols * shapes[l].yChls;
+        }
+    }
+
+    for(size_t l = 0; l + 1 < layers.size(); ++l)
+    {
+        needed += (double)shapes[l].yRows * shapes[l].yCols * shapes[l].yChls;
+    }
+    return computed > 0 ? 1 - needed / computed : 0;
+}
+
+// a model of the DRAM traffic of a chain, which assumes that each tensor that is written and read back by a separate pass
+// (an intermediate output or an unrolled input) round-trips through DRAM, and that the working set of a fused band stays in cache
+struct ChainTraffic
+{
+    double bytes;              // bytes read from and written to DRAM
+    double recomputedFraction; // fraction of the intermediate outputs that are computed more than once (halo recomputation)
+};
+
+// Gets the modeled traffic of running the chain one layer at a time
+template <typename ElementType>
+ChainTraffic GetLayerByLayerTraffic(const std::vector<ConvLayer<ElementType>>& layers, int xRows, int xCols)
+{
+    auto shapes = GetChainShapes(layers, xRows, xCols);
+    double elements = (double)xRows * xCols * shapes[0].xChls;
+    for(size_t l = 0; l < layers.size(); ++l)
+    {
+        const auto& layer = layers[l];
+        double filterSize = (double)layer.wCount * layer.wRows * layer.wCols * layer.wChls;
+        double unrolledSize = (double)shapes[l].yRows * shapes[l].yCols * layer.wRows * layer.wCols * layer.wChls;
+        double outputSize = (double)shapes[l].yRows * shapes[l].yCols * shapes[l].yChls;
+
+        // the unrolled input is written and read, and each output except the last is written and read by the next layer
+        elements += filterSize + 2 * unrolledSize + (l + 1 < layers.size() ? 2 : 1) * outputSize;
+    }
+    return { elements * sizeof(ElementType), 0 };
+}
+
+// Gets the modeled traffic of running the chain fused, with the given number of rows in each band (or 0 to run the chain one
+// layer at a time)
+template <typename ElementType>
+ChainTraffic GetFusedTraffic(const std::vector<ConvLayer<ElementType>>& layers, int xRows, int xCols, int bandRows)
+{
+    if(bandRows <= 0)
+    {
+        return GetLayerByLayerTraffic(layers, xRows, xCols);
+    }
+
+    auto shapes = GetChainShapes(layers, xRows, xCols);
+    int yRows = shapes.back().yRows;
+
+    // each band reads its input rows (including halo rows) and the filters of each layer once per chunk, and writes its rows of the
+    // last layer's output
+    double elements = (double)shapes.back().yRows * shapes.back().yCols * shapes.back().yChls;
+    auto chunkRows = GetFusedChunkRows(layers, shapes, bandRows);
+    for(int bandBegin = 0; bandBegin < yRows; bandBegin += bandRows)
+    {
+        auto layerRows = GetFusedLayerRows(layers, std::min(bandRows, yRows - bandBegin));
+        for(size_t l = 0; l < layers.size(); ++l)
+        {
+            const auto& layer = layers[l];
+            int chunkCount = (layerRows[l] + chunkRows[l] - 1) / chunkRows[l];
+            elements += (double)chunkCount * layer.wCount * layer.wRows * layer.wCols * layer.wChls;
+        }
+        int inputRows = (layerRows[0] - 1) * layers[0].vStride + layers[0].wRows;
+        elements += (double)inputRows * xCols * shapes[0].xChls;
+    }
+    return { elements * sizeof(ElementType), GetFusedRecomputedFraction(layers, shapes, bandRows) };
+}
+
+// the largest fraction of recomputed intermediate outputs for which fusing a chain is worthwhile, since the recomputation costs
+// arithmetic while fusion only saves memory traffic
+const double maxFusedRecomputedFraction = 0.1;
+
+// Gets the number of rows of the last layer's output in each band: the largest number for which the band's intermediate outputs
+// fit in fusedIntermediateCacheSize. The unrolled input does not limit the bands, since each layer unrolls its rows in chunks that
+// fit in the rest of the cache. Returns 0, which runs the chain one layer at a time, if the entire chain already fits in the
+// cache, if the bands that fit recompute more than maxFusedRecomputedFraction of the intermediate outputs, because the halo rows
+// are large compared to the bands (deep chains, large filters, or wide layers of which only a few rows fit in the cache), or if
+// the modeled traffic of the fused chain is not lower than that of the layer-by-layer chain (see GetFusedTraffic).
+template <typename ElementType>
+int GetFusedBandRows(const std::vector<ConvLayer<ElementType>>& layers, int xRows, int xCols)
+{
+    if((long long)GetLayerByLayerSpaceSize(layers, xRows, xCols) * (long long)sizeof(ElementType) <= (long long)fusedLayersCacheSize)
+    {
+        return 0;
+    }
+
+    auto shapes = GetChainShapes(layers, xRows, xCols);
+    int bandRows = shapes.back().yRows;
+    while(bandRows > 1 && 2LL * GetFusedIntermediateSize(layers, shapes, bandRows) * (long long)sizeof(ElementType) > (long long)fusedIntermediateCacheSize)
+    {
+        --bandRows;
+    }
+
+    if(GetFusedRecomputedFraction(layers, shapes, bandRows) > maxFusedRecomputedFraction)
+    {
+        return 0;
+    }
+
+    // each chunk rereads the filters of its layer, which can cost more traffic than fusion saves
+    if(GetFusedTraffic(layers, xRows, xCols, bandRows).bytes >= GetLayerByLayerTraffic(layers, xRows, xCols).bytes)
+    {
+        return 0;
+    }
+    return bandRows;
+}
+
+// Gets the number of bands that are processed concurrently, each with its own slice of the temporary space
+inline int GetFusedSliceCount(int yRows, int bandRows)
+{
+    int bandCount = (yRows + bandRows - 1) / bandRows;
+    return std::min(bandCount, ThreadPool::GetShared().GetThreadCount());
+}
+
+// Gets the size of the temporary space used by the fused convolution with the given number of rows in each band (or 0 to run
+// the chain one layer at a time)
+template <typename ElementType>
+int GetFusedSpaceSize(const std::vector<ConvLayer<ElementType>>& layers, int xRows, int xCols, int bandRows)
+{
+    if(bandRows <= 0)
+    {
+        return GetLayerByLayerSpaceSize(layers, xRows, xCols);
+    }
+
+    auto shapes = GetChainShapes(layers, xRows, xCols);
+    return GetFusedBandSpaceSize(layers, shapes, bandRows) * GetFusedSliceCount(shapes.back().yRows, bandRows);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution of a chain of layers, one layer at a time
+// * each layer is an unrolled-input convolution of the entire output of the previous layer
+// * filters in filter-major order
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size GetLayerByLayerSpaceSize(layers, xRows, xCols)
+//
+// layers: the layers of the chain
+// X: 3-dimensional input tensor of the first layer in row-major order
+// Y: 3-dimensional output tensor of the last layer in row-major order
+// xRows: number of rows in X
+// xCols: number of columns in X
+// space: pointer to temporary space of size at least GetLayerByLayerSpaceSize(layers, xRows, xCols)
+template <typename ElementType>
+void Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput> properties,
+    const std::vector<ConvLayer<ElementType>>& layers,
+    const ElementType* X,
+    ElementType* Y,
+    int xRows,
+    int xCols,
+    ElementType* space)
+{
+    auto shapes = GetChainShapes(layers, xRows, xCols);
+    int layerCount = (int)layers.size();
+    int intermediateSize = 0;
+    for(int l = 0; l + 1 < layerCount; ++l)
+    {
+        intermediateSize = std::max(intermediateSize, shapes[l].yRows * shapes[l].yCols * shapes[l].yChls);
+    }
+
+    ElementType* buffers[2] = { space, space + intermediateSize };
+    const ElementType* input = X;
+    for(int l = 0; l < layerCount; ++l)
+    {
+        const auto& layer = layers[l];
+        ElementType* output = l + 1 < layerCount ? buffers[l % 2] : Y;
+        Convolution(properties, layer.W, input, output, layer.wCount, layer.wRows, layer.wCols, layer.wChls, layer.vStride, layer.hStride, shapes[l].yRows, shapes[l].yCols, space + 2 * intermediateSize);
+        input = output;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution of a chain of layers, fused
+// * the last layer's output is split into bands of rows, and each band is computed depth-first through all of the layers, so the
+//   band's intermediate outputs and unrolled inputs stay in cache instead of being written to memory as full tensors
+// * within a band, each layer unrolls and multiplies its rows in chunks of GetFusedChunkRows rows
+// * the halo rows that a band shares with the next band are recomputed by both bands
+// * bands run concurrently on the shared thread pool, each with its own slice of the temporary space, and BLAS restricted to a
+//   single thread
+// * unrolled input
+// * filters in filter-major order
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * if bandRows is 0, runs the chain one layer at a time instead (see GetFusedBandRows)
+// * requires temporary space of size GetFusedSpaceSize(layers, xRows, xCols, bandRows)
+//
+// layers: the layers of the chain
+// X: 3-dimensional input tensor of the first layer in row-major order
+// Y: 3-dimensional output tensor of the last layer in row-major order
+// xRows: number of rows in X
+// xCols: number of columns in X
+// bandRows: number of rows of the last layer's output in each band, or 0 (see GetFusedBandRows)
+// space: pointer to temporary space of size at least GetFusedSpaceSize(layers, xRows, xCols, bandRows)
+template <typename ElementType>
+void Convolution(ConvProperties<FilterMajorFilters, FusedLayers, RowMajorInput, RowMajorOutput, UnrolledInput>,
+    const std::vector<ConvLayer<ElementType>>& layers,
+    const ElementType* X,
+    ElementType* Y,
+    int xRows,
+    int xCols,
+    int bandRows,
+    ElementType* space)
+{
+    if(bandRows <= 0)
+    {
+        Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{}, layers, X, Y, xRows, xCols, space);
+        return;
+    }
+
+    auto shapes = GetChainShapes(layers, xRows, xCols);
+    int layerCount = (int)layers.size();
+    int yRows = shapes.back().yRows;
+    int bandCount = (yRows + bandRows - 1) / bandRows;
+    int sliceCount = GetFusedSliceCount(yRows, bandRows);
+    int sliceSize = GetFusedBandSpaceSize(layers, shapes, bandRows);
+    int intermediateSize = GetFusedIntermediateSize(layers, shapes, bandRows);
+    auto chunkRows = GetFusedChunkRows(layers, shapes, bandRows);
+
+    // each slice of the temporary space processes the bands slice, slice + sliceCount, slice + 2 * sliceCount, ...
+    SingleThreadedBlasScope blasScope;
+    ThreadPool::GetShared().ParallelFor(0, sliceCount, 1, [&](int sliceBegin, int sliceEnd)
+    {
+        std::vector<int> rowBegins(layerCount);
+        std::vector<int> rowEnds(layerCount);
+        for(int slice = sliceBegin; slice < sliceEnd; ++slice)
+        {
+            ElementType* buffers[2] = { space + slice * sliceSize, space + slice * sliceSize + intermediateSize };
+            ElementType* U = space + slice * sliceSize + 2 * intermediateSize;
+
+            for(int band = slice; band < bandCount; band += sliceCount)
+            {
+                // the range of output rows that each layer computes for this band
+                rowBegins[layerCount - 1] = band * bandRows;
+                rowEnds[layerCount - 1] = std::min(yRows, (band + 1) * bandRows);
+                for(int l = layerCount - 1; l > 0; --l)
+                {
+                    rowBegins[l - 1] = rowBegins[l] * layers[l].vStride;
+                    rowEnds[l - 1] = (rowEnds[l] - 1) * layers[l].vStride + layers[l].wRows;
+                }
+
+                // compute the band depth-first, reading each layer's input rows from the previous layer's buffer
+                const ElementType* input = X + rowBegins[0] * layers[0].vStride * xCols * shapes[0].xChls;
+                for(int l = 0; l < layerCount; ++l)
+                {
+                    const auto& layer = layers[l];
+                    int rowCount = rowEnds[l] - rowBegins[l];
+                    int uCols = layer.wRows * layer.wCols * layer.wChls;
+
+                    // the last layer writes its rows of Y, the other layers write to the buffer that the previous layer did not use
+                    ElementType* output = l + 1 < layerCount ? buffers[l % 2] : Y + rowBegins[l] * shapes[l].yCols * shapes[l].yChls;
+                    for(int chunkBegin = 0; chunkBegin < rowCount; chunkBegin += chunkRows[l])
+                    {
+                        int chunkCount = std::min(chunkRows[l], rowCount - chunkBegin);
+                        int uRows = chunkCount * shapes[l].yCols;
+                        const ElementType* chunkInput = input + chunkBegin * layer.vStride * shapes[l].xCols * shapes[l].xChls;
+                        RowMajInputUnrollSerial(chunkInput, U, layer.wRows, layer.wCols, layer.wChls, layer.vStride, layer.hStride, chunkCount, shapes[l].yCols, uRows, uCols);
+                        Gemm(RowMaj, ColMaj, RowMaj, uRows, layer.wCount, uCols, 1, U, layer.W, 0, output + chunkBegin * shapes[l].yCols * shapes[l].yChls);
+                    }
+                    input = output;
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,323 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     HalfPrecision.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__F16C__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+//
+// 16-bit floating point storage types. Both types convert implicitly to and from float, so all arithmetic is done in 32-bit floating point.
+//
+
+// IEEE 754 half precision: 1 sign bit, 5 exponent bits, 10 mantissa bits
+class Float16
+{
+public:
+    // constructors
+    Float16() = default;
+    Float16(float value) : _bits(FromFloat(value)) {}
+
+    // conversion to float
+    operator float() const { return ToFloat(_bits); }
+
+    // gets the bit representation
+    uint16_t Bits() const { return _bits; }
+
+private:
+    static uint16_t FromFloat(float value);
+    static float ToFloat(uint16_t bits);
+
+    uint16_t _bits;
+};
+
+// bfloat16: the upper half of an IEEE 754 single precision float, with 1 sign bit, 8 exponent bits, 7 mantissa bits
+class BFloat16
+{
+public:
+    // constructors
+    BFloat16() = default;
+    BFloat16(float value) : _bits(FromFloat(value)) {}
+
+    // conversion to float
+    operator float() const { return ToFloat(_bits); }
+
+    // gets the bit representation
+    uint16_t Bits() const { return _bits; }
+
+private:
+    static uint16_t FromFloat(float value);
+    static float ToFloat(uint16_t bits);
+
+    uint16_t _bits;
+};
+
+//
+//
+//
+
+inline uint16_t Float16::FromFloat(float value)
+{
+#if defined(__F16C__)
+    return (uint16_t)_cvtss_sh(value, 0);
+#else
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t exponent = (x >> 23) & 0xff;
+    uint32_t mantissa = x & 0x7fffff;
+
+    // infinity and NaN
+    if(exponent == 0xff)
+    {
+        return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+
+    // overflow to infinity
+    int halfExponent = (int)exponent - 127 + 15;
+    if(halfExponent >= 0x1f)
+    {
+        return (uint16_t)(sign | 0x7c00);
+    }
+
+    // subnormal half or underflow to zero, rounded to nearest even
+    if(halfExponent <= 0)
+    {
+        if(halfExponent < -10)
+        {
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000;
+        int shift = 14 - halfExponent;
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (half & 1)))
+        {
+            ++half;
+        }
+        return (uint16_t)(sign | half);
+    }
+
+    // normal half, rounded to nearest even (a carry out of the mantissa correctly increments the exponent)
+    uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fff;
+    if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+    {
+        ++half;
+    }
+    return (uint16_t)(sign | half);
+#endif
+}
+
+inline float Float16::ToFloat(uint16_t bits)
+{
+#if defined(__F16C__)
+    return _cvtsh_ss(bits);
+#else
+    uint32_t sign = (uint32_t)(bits & 0x8000) << 16;
+    uint32_t exponent = (bits >> 10) & 0x1f;
+    uint32_t mantissa = bits & 0x3ff;
+
+    uint32_t x;
+    if(exponent == 0x1f)
+    {
+        // infinity and NaN
+        x = sign | 0x7f800000 | (mantissa << 13);
+    }
+    else if(exponent == 0)
+    {
+        if(mantissa == 0)
+        {
+            // zero
+            x = sign;
+        }
+        else
+        {
+            // subnormal half, normalized as a float
+            int shift = 0;
+            while((mantissa & 0x400) == 0)
+            {
+                mantissa <<= 1;
+                ++shift;
+            }
+            x = sign | ((uint32_t)(127 - 15 + 1 - shift) << 23) | ((mantissa & 0x3ff) << 13);
+        }
+    }
+    else
+    {
+        // normal half
+        x = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float value;
+    std::memcpy(&value, &x, sizeof(value));
+    return value;
+#endif
+}
+
+inline uint16_t BFloat16::FromFloat(float value)
+{
+    uint32_t x;
+    std::memcpy(&x, &value, sizeof(x));
+
+    // keep NaN a (quiet) NaN
+    if((x & 0x7fffffff) > 0x7f800000)
+    {
+        return (uint16_t)((x >> 16) | 0x40);
+    }
+
+    // round to nearest even
+    x += 0x7fff + ((x >> 16) & 1);
+    return (uint16_t)(x >> 16);
+}
+
+inline float BFloat16::ToFloat(uint16_t bits)
+{
+    uint32_t x = (uint32_t)bits << 16;
+    float value;
+    std::memcpy(&value, &x, sizeof(value));
+    return value;
+}
+
+// Converts an array of Float16 elements to float, four at a time when the instruction set allows
+inline void ConvertToFloat(const Float16* source, float* target, int count)
+{
+    int i = 0;
+#if defined(__F16C__)
+    for(; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(target + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(source + i))));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    // shifting the exponent and mantissa into place and multiplying by 2^(127 - 15) rebiases the exponent exactly, including for
+    // subnormal halves; results at or above 2^16 come from infinity or NaN, which get the maximal float exponent
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i magnitudeMask = _mm_set1_epi32(0x7fff);
+    const __m128i signMask = _mm_set1_epi32(0x8000);
+    const __m128i infinityExponent = _mm_set1_epi32(0x7f800000);
+    const __m128 rebias = _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23));
+    const __m128 wasInfinityOrNaN = _mm_castsi128_ps(_mm_set1_epi32((127 + 16) << 23));
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i bits = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)(source + i)), zero);
+        __m128 value = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(bits, magnitudeMask), 13)), rebias);
+        __m128i x = _mm_or_si128(_mm_castps_si128(value), _mm_and_si128(_mm_castps_si128(_mm_cmpge_ps(value, wasInfinityOrNaN)), infinityExponent));
+        x = _mm_or_si128(x, _mm_slli_epi32(_mm_and_si128(bits, signMask), 16));
+        _mm_storeu_ps(target + i, _mm_castsi128_ps(x));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        target[i] = source[i];
+    }
+}
+
+// Converts an array of BFloat16 elements to float, eight at a time when the instruction set allows
+inline void ConvertToFloat(const BFloat16* source, float* target, int count)
+{
+    int i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    // interleaving zeros below each element shifts it into the upper half of a float
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 8 <= count; i += 8)
+    {
+        __m128i bits = _mm_loadu_si128((const __m128i*)(source + i));
+        _mm_storeu_ps(target + i, _mm_castsi128_ps(_mm_unpacklo_epi16(zero, bits)));
+        _mm_storeu_ps(target + i + 4, _mm_castsi128_ps(_mm_unpackhi_epi16(zero, bits)));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        target[i] = source[i];
+    }
+}
+
+// Converts an array of floats to Float16 elements, rounded to nearest even, four at a time when the instruction set allows
+inline void ConvertFromFloat(const float* source, Float16* target, int count)
+{
+    int i = 0;
+#if defined(__F16C__)
+    for(; i + 4 <= count; i += 4)
+    {
+        _mm_storel_epi64((__m128i*)(target + i), _mm_cvtps_ph(_mm_loadu_ps(source + i), 0));
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    // the same cases as Float16::FromFloat, computed for all elements and selected with masks: infinity and NaN, subnormal halves
+    // (rounded by adding a float whose exponent aligns the half mantissa with the float mantissa), and normal halves (rebiased and
+    // rounded in the integer representation)
+    const __m128i signMask = _mm_set1_epi32((int)0x80000000u);
+    const __m128i infinity = _mm_set1_epi32(0x7f800000);
+    const __m128i halfOverflow = _mm_set1_epi32((127 + 16) << 23);
+    const __m128i halfNormal = _mm_set1_epi32((127 - 14) << 23);
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalRebias = _mm_set1_epi32((int)(((uint32_t)(15 - 127) << 23) + 0xfff));
+    const __m128i one = _mm_set1_epi32(1);
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_castps_si128(_mm_loadu_ps(source + i));
+        __m128i sign = _mm_and_si128(x, signMask);
+        x = _mm_xor_si128(x, sign);
+
+        __m128i special = _mm_or_si128(_mm_set1_epi32(0x7c00), _mm_and_si128(_mm_cmpgt_epi32(x, infinity), _mm_set1_epi32(0x200)));
+        __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(x), _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+        __m128i odd = _mm_and_si128(_mm_srli_epi32(x, 13), one);
+        __m128i normal = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x, normalRebias), odd), 13);
+
+        __m128i isSpecial = _mm_cmpgt_epi32(x, _mm_sub_epi32(halfOverflow, one));
+        __m128i isSubnormal = _mm_cmplt_epi32(x, halfNormal);
+        __m128i half = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+        half = _mm_or_si128(_mm_and_si128(isSpecial, special), _mm_andnot_si128(isSpecial, half));
+        half = _mm_or_si128(half, _mm_srli_epi32(sign, 16));
+
+        // sign-extending the 16-bit results lets the signed saturating pack keep them unchanged
+        half = _mm_srai_epi32(_mm_slli_epi32(half, 16), 16);
+        _mm_storel_epi64((__m128i*)(target + i), _mm_packs_epi32(half, half));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        target[i] = source[i];
+    }
+}
+
+// Converts an array of floats to BFloat16 elements, rounded to nearest even, four at a time when the instruction set allows
+inline void ConvertFromFloat(const float* source, BFloat16* target, int count)
+{
+    int i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+    // the same cases as BFloat16::FromFloat, computed for all elements and selected with a mask
+    const __m128i magnitudeMask = _mm_set1_epi32(0x7fffffff);
+    const __m128i infinity = _mm_set1_epi32(0x7f800000);
+    const __m128i roundingBias = _mm_set1_epi32(0x7fff);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i quietBit = _mm_set1_epi32(0x40);
+    for(; i + 4 <= count; i += 4)
+    {
+        __m128i x = _mm_castps_si128(_mm_loadu_ps(source + i));
+        __m128i isNaN = _mm_cmpgt_epi32(_mm_and_si128(x, magnitudeMask), infinity);
+        __m128i nan = _mm_or_si128(_mm_srli_epi32(x, 16), quietBit);
+        __m128i rounded = _mm_srli_epi32(_mm_add_epi32(x, _mm_add_epi32(roundingBias, _mm_and_si128(_mm_srli_epi32(x, 16), one))), 16);
+        __m128i half = _mm_or_si128(_mm_and_si128(isNaN, nan), _mm_andnot_si128(isNaN, rounded));
+
+        // sign-extending the 16-bit results lets the signed saturating pack keep them unchanged
+        half = _mm_srai_epi32(_mm_slli_epi32(half, 16), 16);
+        _mm_storel_epi64((__m128i*)(target + i), _mm_packs_epi32(half, half));
+    }
+#endif
+    for(; i < count; ++i)
+    {
+        target[i] = source[i];
+    }
+}
@@ -0,0 +1,161 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     IncrementalConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "ConvProperties.h"
+
+#include <algorithm>
+#include <vector>
+
+// a rectangle of rows [row, row + rows) and columns [col, col + cols) of a tensor, which covers all of the channels
+struct TensorRectangle
+{
+    int row;
+    int col;
+    int rows;
+    int cols;
+};
+
+// Gets the rectangle of output elements whose receptive fields intersect a rectangle of input elements (empty if there are none)
+inline TensorRectangle GetAffectedOutputRectangle(const TensorRectangle& input, int wRows, int wCols, int vStride, int hStride, int yRows, int yCols)
+{
+    // output row i reads input rows [i * vStride, i * vStride + wRows), and similarly for columns
+    auto GetRange = [](int begin, int end, int wSize, int stride, int ySize, int& outputBegin, int& outputEnd)
+    {
+        outputBegin = std::max(0, (begin - wSize + stride) / stride);
+        outputEnd = std::min(ySize, (end - 1) / stride + 1);
+    };
+
+    int rowBegin, rowEnd, colBegin, colEnd;
+    GetRange(input.row, input.row + input.rows, wRows, vStride, yRows, rowBegin, rowEnd);
+    GetRange(input.col, input.col + input.cols, wCols, hStride, yCols, colBegin, colEnd);
+    if(input.rows <= 0 || input.cols <= 0 || rowBegin >= rowEnd || colBegin >= colEnd)
+    {
+        return { 0, 0, 0, 0 };
+    }
+    return { rowBegin, colBegin, rowEnd - rowBegin, colEnd - colBegin };
+}
+
+// Gets the output rectangles that are affected by a set of changed input rectangles, where affected rectangles that overlap are
+// merged into their bounding rectangle, so that no output element is computed twice
+inline std::vector<TensorRectangle> GetAffectedOutputRectangles(const std::vector<TensorRectangle>& changed, int wRows, int wCols, int vStride, int hStride, int yRows, int yCols)
+{
+    std::vector<TensorRectangle> affected;
+    for(const auto& input : changed)
+    {
+        auto rectangle = GetAffectedOutputRectangle(input, wRows, wCols, vStride, hStride, yRows, yCols);
+        if(rectangle.rows == 0)
+        {
+            continue;
+        }
+
+        // merge with every overlapping rectangle, repeating until the merged rectangle overlaps none of the others
+        bool isMerged = true;
+        while(isMerged)
+        {
+            isMerged = false;
+            for(size_t i = 0; i < affected.size(); ++i)
+            {
+                const auto& other = affected[i];
+                if(rectangle.row < other.row + other.rows && other.row < rectangle.row + rectangle.rows && rectangle.col < other.col + other.cols && other.col < rectangle.col + rectangle.cols)
+                {
+                    int rowEnd = std::max(rectangle.row + rectangle.rows, other.row + other.rows);
+                    int colEnd = std::max(rectangle.col + rectangle.cols, other.col + other.cols);
+                    rectangle.row = std::min(rectangle.row, other.row);
+                    rectangle.col = std::min(rectangle.col, other.col);
+                    rectangle.rows = rowEnd - rectangle.row;
+                    rectangle.cols = colEnd - rectangle.col;
+                    affected.erase(affected.begin() + i);
+                    isMerged = true;
+                    break;
+                }
+            }
+        }
+        affected.push_back(rectangle);
+    }
+    return affected;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution, updated incrementally
+// * given the output of the previous input, and the rectangles of the current input that differ from the previous input,
+//   recomputes only the output rectangles whose receptive fields intersect a changed rectangle
+// * each affected output rectangle is computed by any convolution variant, on a copy of the input rectangle that it reads
+//   (the output rectangle expanded by the receptive field), and is then copied into Y
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size (xRows * xCols * wChls + yRows * yCols * wCount) in the worst case, where all of the
+//   output is affected
+//
+// X: 3-dimensional current input tensor in row-major order
+// Y: 3-dimensional output tensor in row-major order, which holds the output of the previous input and is updated in place
+// changed: the rectangles of X that changed since the previous input
+// wCount: number of filters
+// wRows: number of rows in each filter
+// wCols: number of columns in each filter
+// wChls: number of channels in each filter
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// convolution: function that is called as convolution(X, Y, rectangleYRows, rectangleYCols) for each affected rectangle, where X is
+//   the rectangle's input in row-major order, with (rectangleYRows - 1) * vStride + wRows rows and (rectangleYCols - 1) * hStride +
+//   wCols columns, and Y receives the rectangle's output in row-major order
+// space: pointer to temporary space of size at least (xRows * xCols * wChls + yRows * yCols * wCount)
+// recomputedFraction: optional pointer that receives the fraction of the output that was recomputed
+template <typename ElementType, typename ConvolutionType>
+void Convolution(ConvProperties<IncrementalUpdate, RowMajorInput, RowMajorOutput>,
+    const ElementType* X,
+    ElementType* Y,
+    const std::vector<TensorRectangle>& changed,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    const ConvolutionType& convolution,
+    ElementType* space,
+    double* recomputedFraction = nullptr)
+{
+    int xCols = (yCols - 1) * hStride + wCols;
+    int xChls = wChls;
+
+    long long recomputedSize = 0;
+    for(const auto& rectangle : GetAffectedOutputRectangles(changed, wRows, wCols, vStride, hStride, yRows, yCols))
+    {
+        // copy the input rectangle that the output rectangle reads into a contiguous tensor
+        int subXRows = (rectangle.rows - 1) * vStride + wRows;
+        int subXCols = (rectangle.cols - 1) * hStride + wCols;
+        int subXRowSize = subXCols * xChls;
+        ElementType* subX = space;
+        for(int row = 0; row < subXRows; ++row)
+        {
+            const ElementType* source = X + ((rectangle.row * vStride + row) * xCols + rectangle.col * hStride) * xChls;
+            std::copy(source, source + subXRowSize, subX + row * subXRowSize);
+        }
+
+        // convolve, and copy the output rectangle into Y
+        int subYRowSize = rectangle.cols * wCount;
+        ElementType* subY = space + subXRows * subXRowSize;
+        convolution(subX, subY, rectangle.rows, rectangle.cols);
+        for(int row = 0; row < rectangle.rows; ++row)
+        {
+            const ElementType* source = subY + row * subYRowSize;
+            std::copy(source, source + subYRowSize, Y + ((rectangle.row + row) * yCols + rectangle.col) * wCount);
+        }
+        recomputedSize += (long long)rectangle.rows * rectangle.cols;
+    }
+
+    if(recomputedFraction != nullptr)
+    {
+        *recomputedFraction = (double)recomputedSize / ((long long)yRows * yCols);
+    }
+}
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     JitRowMajInputUnroll.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "UnrolledInputConv_rI.h"
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+// the JIT code emitter supports x86-64 with the System V calling convention (Linux, macOS)
+#if defined(USE_JIT) && (defined(__x86_64__) || defined(_M_X64)) && !defined(_WIN32)
+#define JIT_AVAILABLE
+#endif
+
+// A minimal x86-64 machine code emitter, which supports only the instructions needed by the generated unroll functions
+class X64Emitter
+{
+public:
+    // general purpose registers, numbered as in their machine encoding
+    enum Register { rax = 0, rsi = 6, rdi = 7, r8 = 8, r9 = 9 };
+
+    // emits a move of a 32-bit immediate into the lower half of a register (which clears the upper half)
+    void MovImmediate(Register target, int32_t value);
+
+    // emits a copy of size bytes (1, 2, 4, 8 or 16) from [source + sourceOffset] to [target + targetOffset], using rax or xmm0
+    void Copy(Register source, int32_t sourceOffset, Register target, int32_t targetOffset, int size);
+
+    // emits an addition of a 32-bit immediate to a 64-bit register
+    void AddImmediate(Register target, int32_t value);
+
+    // emits a decrement of the lower half of a register
+    void Decrement(Register target);
+
+    // emits a conditional jump to the given code position, taken if the last result was not zero
+    void JumpIfNotZero(size_t position);
+
+    // emits a return instruction
+    void Return();
+
+    // gets the current code position
+    size_t Position() const { return _code.size(); }
+
+    // gets the emitted machine code
+    const std::vector<uint8_t>& Code() const { return _code; }
+
+private:
+    void EmitByte(uint8_t value) { _code.push_back(value); }
+    void EmitInt32(int32_t value);
+    void EmitRex(bool isWide, Register reg, Register rm);
+    void EmitMemoryOperand(int reg, Register base, int32_t offset);
+
+    std::vector<uint8_t> _code;
+};
+
+// A function generated at runtime that unrolls a row-major input tensor of one specific shape, with all loop bounds, strides and
+// pointer offsets baked into the machine code
+class JitRowMajInputUnroll
+{
+public:
+    // Gets the generated function for the given shape, generating it on first use and caching it for later calls. Returns nullptr if
+    // JIT code generation is unavailable (disabled at compile time or an unsupported platform) or the shape is too large.
+    // elementSize: size in bytes of each element (the input and unrolled elements must have the same type)
+    static const JitRowMajInputUnroll* Get(int elementSize, int wRows, int wCols, int wChls, int vStride, int hStride, int yRows, int yCols);
+
+    // unrolls the input tensor X into the unrolled input matrix U
+    void operator()(const void* X, void* U) const { _function(X, U); }
+
+    ~JitRowMajInputUnroll();
+
+private:
+    using FunctionType = void (*)(const void* X, void* U);
+
+    JitRowMajInputUnroll(const std::vector<uint8_t>& code);
+    JitRowMajInputUnroll(const JitRowMajInputUnroll&) = delete;
+    JitRowMajInputUnroll& operator=(const JitRowMajInputUnroll&) = delete;
+
+    void* _memory = nullptr;
+    size_t _size = 0;
+    FunctionType _function = nullptr;
+};
+
+// Helper function that unrolls a row-major input tensor into an unrolled input matrix, using code generated at runtime for the
+// specific shape, and falls back to RowMajInputUnroll when JIT code generation is unavailable or the element types differ
+template <typename InputType, typename ElementType>
+void JitRowMajInputUnrollOrFallback(const InputType* X, 
+    ElementType* U,
+    int wRows, 
+    int wCols, 
+    int wChls, 
+    int vStride, 
+    int hStride, 
+    int yRows, 
+    int yCols,
+    int uRows,
+    int uCols)
+{
+    if(std::is_same<InputType, ElementType>::value)
+    {
+        auto function = JitRowMajInputUnroll::Get((int)sizeof(ElementType), wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+        if(function != nullptr)
+        {
+            (*function)(X, U);
+            return;
+        }
+    }
+
+    RowMajInputUnroll(X, U, wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+}
@@ -0,0 +1,203 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     LowRankFilters.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+// A filter tensor whose spatial kernels (one wRows x wCols kernel per filter and channel) are each approximated by a sum of rank
+// outer products of a vertical 1D filter (wRows elements) and a horizontal 1D filter (wCols elements)
+template <typename ElementType>
+struct LowRankFilters
+{
+    int wCount;
+    int wRows;
+    int wCols;
+    int wChls;
+    int rank;
+    double relativeError;               // Frobenius norm of the approximation error, relative to the Frobenius norm of the filters
+    std::vector<ElementType> vertical;  // vertical 1D filters, in filter, channel, rank, row major-to-minor order
+    std::vector<ElementType> horizontal;// horizontal 1D filters, in filter, channel, rank, column major-to-minor order
+};
+
+// Computes the singular value decomposition of a small matrix M = A * transpose(V) with one-sided Jacobi rotations, where the columns
+// of A are orthogonal and their norms are the singular values, and V is orthonormal. The columns are sorted by decreasing norm.
+// M: pointer to a rows x cols matrix in row-major order
+// A: pointer to a rows x cols matrix in column-major order, receives U * Sigma
+// V: pointer to a cols x cols matrix in column-major order, receives V
+inline void JacobiSvd(const double* M, double* A, double* V, int rows, int cols)
+{
+    for(int i = 0; i < rows; ++i)
+    {
+        for(int j = 0; j < cols; ++j)
+        {
+            A[j * rows + i] = M[i * cols + j];
+        }
+    }
+    for(int j = 0; j < cols * cols; ++j)
+    {
+        V[j] = (j % (cols + 1) == 0) ? 1 : 0;
+    }
+
+    // rotate pairs of columns until all of them are orthogonal
+    for(int sweep = 0; sweep < 30; ++sweep)
+    {
+        bool isOrthogonal = true;
+        for(int p = 0; p < cols; ++p)
+        {
+            for(int q = p + 1; q < cols; ++q)
+            {
+                double* a = A + p * rows;
+                double* b = A + q * rows;
+                double alpha = std::inner_product(a, a + rows, a, 0.0);
+                double beta = std::inner_product(b, b + rows, b, 0.0);
+                double gamma = std::inner_product(a, a + rows, b, 0.0);
+                if(std::abs(gamma) <= 1.0e-15 * std::sqrt(alpha * beta))
+                {
+                    continue;
+                }
+                isOrthogonal = false;
+
+                double zeta = (beta - alpha) / (2 * gamma);
+                double t = (zeta >= 0 ? 1 : -1) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                double c = 1 / std::sqrt(1 + t * t);
+                double s = c * t;
+                auto Rotate = [&](double* x, double* y, int size)
+                {
+                    for(int i = 0; i < size; ++i)
+                    {
+                        double xi = x[i];
+                        x[i] = c * xi - s * y[i];
+                        y[i] = s * xi + c * y[i];
+                    }
+                };
+                Rotate(a, b, rows);
+                Rotate(V + p * cols, V + q * cols, cols);
+            }
+        }
+        if(isOrthogonal)
+        {
+            break;
+        }
+    }
+
+    // sort the columns by decreasing norm
+    for(int p = 0; p < cols; ++p)
+    {
+        int best = p;
+        double bestNorm = -1;
+        for(int q = p; q < cols; ++q)
+        {
+            double norm = std::inner_product(A + q * rows, A + (q + 1) * rows, A + q * rows, 0.0);
+            if(norm > bestNorm)
+            {
+                best = q;
+                bestNorm = norm;
+            }
+        }
+        std::swap_ranges(A + p * rows, A + (p + 1) * rows, A + best * rows);
+        std::swap_ranges(V + p * cols, V + (p + 1) * cols, V + best * cols);
+    }
+}
+
+// Factors a filter tensor into vertical and horizontal 1D filters, using the smallest rank whose relative approximation error is at
+// most maxRelativeError, but no more than maxRank (a rank of min(wRows, wCols) is exact)
+// W: 4-dimensional weights tensor in filter-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// maxRelativeError: error bound, relative to the Frobenius norm of W
+// maxRank: upper bound on the rank
+template <typename ElementType>
+LowRankFilters<ElementType> GetLowRankFilters(const ElementType* W, int wCount, int wRows, int wCols, int wChls, double maxRelativeError, int maxRank)
+{
+    int fullRank = std::min(wRows, wCols);
+    int kernelCount = wCount * wChls;
+
+    // decompose each spatial kernel, and accumulate the energy (sum of squared singular values) at each rank
+    std::vector<double> M(wRows * wCols);
+    std::vector<double> A(kernelCount * wRows * wCols);
+    std::vector<double> V(kernelCount * wCols * wCols);
+    std::vector<double> energy(wCols);
+    for(int filter = 0; filter < wCount; ++filter)
+    {
+        for(int wChl = 0; wChl < wChls; ++wChl)
+        {
+            for(int wRow = 0; wRow < wRows; ++wRow)
+            {
+                for(int wCol = 0; wCol < wCols; ++wCol)
+                {
+                    M[wRow * wCols + wCol] = W[((filter * wRows + wRow) * wCols + wCol) * wChls + wChl];
+                }
+            }
+
+            int kernel = filter * wChls + wChl;
+            double* a = A.data() + kernel * wRows * wCols;
+            JacobiSvd(M.data(), a, V.data() + kernel * wCols * wCols, wRows, wCols);
+            for(int t = 0; t < wCols; ++t)
+            {
+                energy[t] += std::inner_product(a + t * wRows, a + (t + 1) * wRows, a + t * wRows, 0.0);
+            }
+        }
+    }
+
+    // choose the rank, where the squared error is the energy of the discarded components
+    double totalEnergy = std::accumulate(energy.begin(), energy.end(), 0.0);
+    int rank = 1;
+    while(rank < std::min(fullRank, maxRank) && std::accumulate(energy.begin() + rank, energy.end(), 0.0) > maxRelativeError * maxRelativeError * totalEnergy)
+    {
+        ++rank;
+    }
+    double errorEnergy = std::accumulate(energy.begin() + rank, energy.end(), 0.0);
+
+    std::vector<ElementType> vertical(kernelCount * rank * wRows);
+    std::vector<ElementType> horizontal(kernelCount * rank * wCols);
+    LowRankFilters<ElementType> filters = { wCount, wRows, wCols, wChls, rank, totalEnergy > 0 ? std::sqrt(errorEnergy / totalEnergy) : 0.0, std::move(vertical), std::move(horizontal) };
+    for(int kernel = 0; kernel < kernelCount; ++kernel)
+    {
+        for(int t = 0; t < rank; ++t)
+        {
+            const double* a = A.data() + (kernel * wCols + t) * wRows;
+            const double* v = V.data() + (kernel * wCols + t) * wCols;
+            std::copy(a, a + wRows, filters.vertical.begin() + (kernel * rank + t) * wRows);
+            std::copy(v, v + wCols, filters.horizontal.begin() + (kernel * rank + t) * wCols);
+        }
+    }
+    return filters;
+}
+
+// Reconstructs the filter tensor approximated by low-rank filters
+// filters: the low-rank filters
+// W: 4-dimensional weights tensor in filter-major order
+template <typename ElementType>
+void GetFilterTensor(const LowRankFilters<ElementType>& filters, ElementType* W)
+{
+    for(int filter = 0; filter < filters.wCount; ++filter)
+    {
+        for(int wChl = 0; wChl < filters.wChls; ++wChl)
+        {
+            int kernel = filter * filters.wChls + wChl;
+            for(int wRow = 0; wRow < filters.wRows; ++wRow)
+            {
+                for(int wCol = 0; wCol < filters.wCols; ++wCol)
+                {
+                    double value = 0;
+                    for(int t = 0; t < filters.rank; ++t)
+                    {
+                        value += (double)filters.vertical[(kernel * filters.rank + t) * filters.wRows + wRow] * filters.horizontal[(kernel * filters.rank + t) * filters.wCols + wCol];
+                    }
+                    W[((filter * filters.wRows + wRow) * filters.wCols + wCol) * filters.wChls + wChl] = (ElementType)value;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,77 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     Numa.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// placement of the memory pages of large allocations (tensors and temporary space) on the NUMA nodes of the computer
+enum class NumaPolicy
+{
+    systemDefault, // the operating system's default policy
+    local,         // each page is placed on the node of the thread that first touches it
+    interleave     // pages are spread round-robin over all nodes
+};
+
+// gets the number of NUMA nodes (1 on non-NUMA computers and on platforms other than Linux)
+int GetNumaNodeCount();
+
+// gets the NUMA node of the given logical processor
+int GetNumaNodeOfCpu(int cpu);
+
+// gets and sets the policy applied to allocations made after the call
+NumaPolicy GetNumaPolicy();
+void SetNumaPolicy(NumaPolicy policy);
+
+// gets the name of a policy, and parses a policy from its name (returns false if the name is not recognized)
+const char* GetNumaPolicyName(NumaPolicy policy);
+bool ParseNumaPolicy(const char* name, NumaPolicy& policy);
+
+// Allocates page-aligned memory and applies the current NUMA policy to it. Allocations smaller than minNumaAllocationSize bytes
+// use the standard heap, since NUMA placement works at page granularity.
+void* NumaAllocate(size_t size);
+void NumaFree(void* data, size_t size);
+
+const size_t minNumaAllocationSize = 1 << 16;
+
+// Standard allocator that allocates with NumaAllocate, for vectors that hold tensor data and temporary space. The elements of
+// a NumaVector are not zeroed by NumaVector(count) or resize(count); pass an explicit value to zero them.
+template <typename T>
+class NumaAllocator
+{
+public:
+    using value_type = T;
+
+    NumaAllocator() = default;
+
+    template <typename U>
+    NumaAllocator(const NumaAllocator<U>&) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(NumaAllocate(count * sizeof(T))); }
+    void deallocate(T* data, size_t count) { NumaFree(data, count * sizeof(T)); }
+
+    // Default-initializes elements instead of value-initializing them, so that a vector of arithmetic elements leaves its pages
+    // untouched when it is created or resized. Each page is then placed by the first thread that writes to it, which for
+    // temporary space is the worker that uses its slice.
+    template <typename U>
+    void construct(U* p) { ::new(static_cast<void*>(p)) U; }
+
+    template <typename U, typename... ArgTypes>
+    void construct(U* p, ArgTypes&&... args) { ::new(static_cast<void*>(p)) U(std::forward<ArgTypes>(args)...); }
+};
+
+template <typename T, typename U>
+bool operator==(const NumaAllocator<T>&, const NumaAllocator<U>&) { return true; }
+
+template <typename T, typename U>
+bool operator!=(const NumaAllocator<T>&, const NumaAllocator<U>&) { return false; }
+
+template <typename T>
+using NumaVector = std::vector<T, NumaAllocator<T>>;
@@ -0,0 +1,189 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     OutOfCoreConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BackgroundIoThread.h"
+#include "ConvProperties.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// default number of bytes of memory used by the tile buffers and the temporary space of one tile
+const long long outOfCoreMemoryBudget = 1LL << 28;
+
+// Gets the number of output rows in each tile, so that the two input tiles, the two output tiles and the unrolled input of one
+// tile fit in the given memory budget
+inline int GetOutOfCoreTileRows(int wCount, int wRows, int wCols, int wChls, int vStride, int hStride, int yRows, int yCols, int elementSize, long long memoryBudget = outOfCoreMemoryBudget)
+{
+    long long xCols = (yCols - 1) * hStride + wCols;
+    long long inputRowSize = 2LL * vStride * xCols * wChls;
+    long long outputRowSize = 2LL * yCols * wCount;
+    long long unrolledRowSize = (long long)yCols * wRows * wCols * wChls;
+    long long rowSize = (inputRowSize + outputRowSize + unrolledRowSize) * elementSize;
+    return (int)std::max(1LL, std::min((long long)yRows, memoryBudget / rowSize));
+}
+
+// the time in milliseconds spent in each part of an out-of-core convolution
+struct OutOfCoreStatistics
+{
+    double ioWaitTime = 0;  // time the calling thread waited for a tile to be read or written
+    double computeTime = 0; // time spent in the convolutions of the tiles
+    double totalTime = 0;   // elapsed time of the entire convolution
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution of an input file into an output file, out of core
+// * the output rows are split into tiles, and each tile's input rows, including the (wRows - vStride) halo rows shared with the
+//   next tile, are read from the input file into one of two input buffers
+// * a background thread reads the next tile and writes the previous tile's output while the current tile is computed by any
+//   convolution variant, so only two input tiles and two output tiles are in memory at a time
+// * input file in row-major order: the raw elements of an xRows x xCols x wChls tensor (including any padding), where
+//   xRows = (yRows - 1) * vStride + wRows and xCols = (yCols - 1) * hStride + wCols
+// * output file in row-major order: the raw elements of a yRows x yCols x wCount tensor
+// * throws std::runtime_error if a file cannot be opened, read or written
+// * the element type cannot be deduced from the arguments, and is given explicitly, as in Convolution<float>(properties, ...)
+//
+// inputFilename: name of the input file
+// outputFilename: name of the output file, which is created or overwritten
+// wCount: number of filters
+// wRows: number of rows in each filter
+// wCols: number of columns in each filter
+// wChls: number of channels in each filter
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor
+// yCols: number of columns in the output tensor
+// tileRows: number of output rows in each tile (see GetOutOfCoreTileRows)
+// convolution: function that is called as convolution(X, Y, tileYRows) for each tile, where X is the tile's input in row-major
+//   order, with (tileYRows - 1) * vStride + wRows rows, and Y receives the tile's tileYRows output rows in row-major order
+// statistics: optional pointer that receives the time spent in each part
+template <typename ElementType, typename ConvolutionType>
+void Convolution(ConvProperties<OutOfCore, RowMajorInput, RowMajorOutput>,
+    const std::string& inputFilename,
+    const std::string& outputFilename,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    int tileRows,
+    const ConvolutionType& convolution,
+    OutOfCoreStatistics* statistics = nullptr)
+{
+    using Clock = std::chrono::steady_clock;
+    auto startTime = Clock::now();
+    double ioWaitTime = 0;
+    double computeTime = 0;
+
+    std::ifstream input(inputFilename, std::ios::binary);
+    std::ofstream output(outputFilename, std::ios::binary | std::ios::trunc);
+    if(!input || !output)
+    {
+        throw std::runtime_error("could not open " + (input ? outputFilename : inputFilename));
+    }
+
+    int xCols = (yCols - 1) * hStride + wCols;
+    long long xRowSize = (long long)xCols * wChls;
+    long long yRowSize = (long long)yCols * wCount;
+    int tileCount = (yRows + tileRows - 1) / tileRows;
+
+    // two input tiles and two output tiles, which alternate between consecutive tiles
+    std::vector<ElementType> inputTiles[2];
+    std::vector<ElementType> outputTiles[2];
+    for(int buffer = 0; buffer < 2; ++buffer)
+    {
+        inputTiles[buffer].resize(((tileRows - 1) * vStride + wRows) * xRowSize);
+        outputTiles[buffer].resize(tileRows * yRowSize);
+    }
+
+    auto GetTileYRows = [&](int tile) { return std::min(tileRows, yRows - tile * tileRows); };
+
+    // reads the input rows of a tile, including its halo rows
+    auto ReadTile = [&](int tile)
+    {
+        long long xRowBegin = (long long)tile * tileRows * vStride;
+        long long size = ((GetTileYRows(tile) - 1) * vStride + wRows) * xRowSize * (long long)sizeof(ElementType);
+        input.seekg(xRowBegin * xRowSize * (long long)sizeof(ElementType));
+        input.read(reinterpret_cast<char*>(inputTiles[tile % 2].data()), size);
+        if(input.gcount() != size)
+        {
+            throw std::runtime_error("could not read " + inputFilename);
+        }
+    };
+
+    // appends the output rows of a tile
+    auto WriteTile = [&](int tile)
+    {
+        long long size = GetTileYRows(tile) * yRowSize * (long long)sizeof(ElementType);
+        output.write(reinterpret_cast<const char*>(outputTiles[tile % 2].data()), size);
+        if(!output)
+        {
+            throw std::runtime_error("could not write " + outputFilename);
+        }
+    };
+
+    auto Wait = [&](std::future<void>& future)
+    {
+        auto begin = Clock::now();
+        future.get();
+        ioWaitTime += std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+    };
+
+    // constructed after the buffers and files, so the destructor finishes any queued job before they are destroyed
+    BackgroundIoThread ioThread;
+    std::future<void> reads[2];
+    std::future<void> writes[2];
+
+    reads[0] = ioThread.Submit([&]() { ReadTile(0); });
+    for(int tile = 0; tile < tileCount; ++tile)
+    {
+        int buffer = tile % 2;
+
+        // read the next tile into the other input buffer, whose tile was computed in the previous iteration
+        if(tile + 1 < tileCount)
+        {
+            reads[1 - buffer] = ioThread.Submit([&, tile]() { ReadTile(tile + 1); });
+        }
+
+        // wait for this tile's input, and for the output buffer to be written out by its previous tile
+        Wait(reads[buffer]);
+        if(writes[buffer].valid())
+        {
+            Wait(writes[buffer]);
+        }
+
+        auto begin = Clock::now();
+        convolution(inputTiles[buffer].data(), outputTiles[buffer].data(), GetTileYRows(tile));
+        computeTime += std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+        writes[buffer] = ioThread.Submit([&, tile]() { WriteTile(tile); });
+    }
+
+    for(auto& write : writes)
+    {
+        if(write.valid())
+        {
+            Wait(write);
+        }
+    }
+
+    if(statistics != nullptr)
+    {
+        statistics->ioWaitTime = ioWaitTime;
+        statistics->computeTime = computeTime;
+        statistics->totalTime = std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+    }
+}
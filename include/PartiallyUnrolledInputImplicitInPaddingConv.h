@@ -11,6 +11,8 @@
 #include "ConvProperties.h"
 #include "Tensor.h"
 
+#include <vector>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // 2D Tensor Convolution
 // * supports only 3x3 receptive field 
@@ -51,7 +53,13 @@ void Convolution(ConvProperties<ImplicitInputPadding, PartiallyUnrolledInput, Ro
     int vCols = wCount;
     int vSize = wChls * wCount;
 
-    auto MultiplyMatrices = [&](const ElementType* P, int pRows, int pCols, int position, int yRow)
+    // the multiplications of the filter positions that reshape the input are collected and performed as a single batch of small GEMMs
+    std::vector<int> batchRows;
+    std::vector<const ElementType*> batchP, batchV;
+    std::vector<ElementType> batchBeta;
+    std::vector<ElementType*> batchZ;
+
+    auto MultiplyMatrices = [&](const ElementType* P, int pRows, int pCols, int position, int yRow, bool isBatched)
     {
         // reshape the relevant part of the filters tensor W into a row-major matrix V
         int vCols = wCount;
@@ -61,8 +69,20 @@ void Convolution(ConvProperties<ImplicitInputPadding, PartiallyUnrolledInput, Ro
         // reshape the relevant part of the output tensor Y into a row-major matrix Z
         ElementType* Z = Y + yRow * vCols;
 
-        // perform matrix multiplication
-        Gemm(RowMaj, RowMaj, RowMaj, pRows, vCols, pCols, 1, P, V, 1, Z);
+        // perform matrix multiplication, or add it to the batch
+        ElementType beta = 1;
+        if(isBatched)
+        {
+            batchRows.push_back(pRows);
+            batchP.push_back(P);
+            batchV.push_back(V);
+            batchBeta.push_back(beta);
+            batchZ.push_back(Z);
+        }
+        else
+        {
+            GemmBatch(1, &pRows, vCols, pCols, &P, &V, &beta, &Z);
+        }
     };
 
     // define a helper function that handles a single spatial filter position without copying input data
@@ -73,7 +93,7 @@ void Convolution(ConvProperties<ImplicitInputPadding, PartiallyUnrolledInput, Ro
         int pCols = wChls;
         const ElementType* P = X + (xRow * yCols + xCol) * wChls; 
 
-        MultiplyMatrices(P, pRows, pCols, position, yRow);
+        MultiplyMatrices(P, pRows, pCols, position, yRow, true);
     };
 
     // define a helper function that handles a single spatial filter position by copying input data
@@ -97,7 +117,8 @@ void Convolution(ConvProperties<ImplicitInputPadding, PartiallyUnrolledInput, Ro
             std::fill_n(P + pRow * pCols, pCols, (ElementType)0);
         }
 
-        MultiplyMatrices(P, pRows, pCols, position, yRow);
+        // P is overwritten by the next filter position, so the multiplication cannot wait for the batch
+        MultiplyMatrices(P, pRows, pCols, position, yRow, false);
     };
 
     // reset the output 
@@ -129,5 +150,6 @@ void Convolution(ConvProperties<ImplicitInputPadding, PartiallyUnrolledInput, Ro
 
     // process the BOTTOM RIGHT filter position across all channels
     ProcessFilterPositionByCopy(8, 1, 1, (yRows - 1) * yCols - 1, 0);
+    // perform the batch of matrix-matrix multiplications
+    GemmBatch((int)batchRows.size(), batchRows.data(), wCount, wChls, batchP.data(), batchV.data(), batchBeta.data(), batchZ.data());
 }
-
@@ -0,0 +1,270 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     PipelinedUnrolledInputConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ConvProperties.h"
+#include "ThreadPool.h"
+#include "UnrolledInputConv_rI.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+// default number of chunks of output rows that the unroll is split into
+const int pipelineChunkCount = 8;
+
+// Gets the number of output rows in each chunk, so that the output rows are split into the given number of chunks
+inline int GetPipelineChunkRows(int yRows, int chunkCount = pipelineChunkCount)
+{
+    return std::max(1, (yRows + chunkCount - 1) / chunkCount);
+}
+
+// the time in milliseconds spent in each stage of a pipelined convolution
+struct PipelineStatistics
+{
+    double unrollTime = 0; // total time spent unrolling chunks, on all threads
+    double gemmTime = 0;   // total time spent multiplying chunks
+    double totalTime = 0;  // elapsed time of the entire convolution
+
+    // Gets the fraction of the unroll time that was hidden behind matrix multiplication, between 0 (the stages ran one after the
+    // other) and 1 (all of the unrolling ran concurrently with matrix multiplication)
+    double GetOverlap() const
+    {
+        if(unrollTime <= 0)
+        {
+            return 0;
+        }
+        double overlap = (unrollTime + gemmTime - totalTime) / unrollTime;
+        return std::max(0.0, std::min(1.0, overlap));
+    }
+};
+
+// the state shared by the consumer and the producer of a pipelined convolution, which may outlive the convolution call if the
+// producer task starts after the consumer has finished
+struct PipelineState
+{
+    enum class ClaimResult { claimed, blocked, finished };
+
+    PipelineState(int chunkCount) : isChunkUnrolled(new std::atomic<bool>[chunkCount]), chunkCount(chunkCount)
+    {
+        for(int chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            isChunkUnrolled[chunk].store(false, std::memory_order_relaxed);
+        }
+    }
+
+    // Claims the next chunk and calls unrollChunk(chunk) on it. A chunk is blocked if it belongs to an input that would overwrite
+    // the unrolled input buffer of an input that is still being multiplied.
+    template <typename UnrollChunkType>
+    ClaimResult TryUnrollNextChunk(int chunksPerInput, int bufferCount, const UnrollChunkType& unrollChunk)
+    {
+        int chunk = nextChunk.load();
+        while(chunk < chunkCount)
+        {
+            int input = chunk / chunksPerInput;
+            if(input >= multipliedInputCount.load(std::memory_order_acquire) + bufferCount)
+            {
+                return ClaimResult::blocked;
+            }
+
+            if(nextChunk.compare_exchange_weak(chunk, chunk + 1))
+            {
+                unrollChunk(chunk);
+                isChunkUnrolled[chunk].store(true, std::memory_order_release);
+                return ClaimResult::claimed;
+            }
+        }
+        return ClaimResult::finished;
+    }
+
+    std::unique_ptr<std::atomic<bool>[]> isChunkUnrolled;
+    std::atomic<int> nextChunk{0};
+    std::atomic<int> multipliedInputCount{0};
+    std::atomic<long long> producerUnrollTime{0}; // in nanoseconds, added before each chunk is marked as unrolled
+    int chunkCount;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution of a batch of inputs
+// * unrolled input, software-pipelined: the output rows are split into chunks, a producer task on the shared thread pool unrolls
+//   the chunks in order, and the calling thread multiplies each chunk as soon as it is unrolled (unrolling any chunk that the
+//   producer has not reached yet, so the convolution never waits for a busy pool)
+// * the unrolled input is double-buffered, so the producer unrolls the next input while the current input is multiplied
+// * filters in filter-major order
+// * input tensors in row-major order
+// * output tensors in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * yRows * yCols * min(inputCount, 2))
+//
+// W: 4-dimensional weights tensor in filter-major order
+// inputs: array of inputCount pointers to 3-dimensional input tensors in row-major order
+// outputs: array of inputCount pointers to 3-dimensional output tensors in row-major order
+// inputCount: number of inputs
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in each output tensor
+// yCols: number of columns in each output tensor
+// chunkRows: number of output rows in each chunk (see GetPipelineChunkRows)
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * yRows * yCols * min(inputCount, 2))
+// statistics: optional pointer that receives the time spent in each stage
+template <typename ElementType>
+void Convolution(ConvProperties<FilterMajorFilters, PipelinedUnroll, RowMajorInput, RowMajorOutput, UnrolledInput>,
+    const ElementType* W,
+    const ElementType* const* inputs,
+    ElementType* const* outputs,
+    int inputCount,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    int chunkRows,
+    ElementType* space,
+    PipelineStatistics* statistics = nullptr)
+{
+    using Clock = std::chrono::steady_clock;
+    auto startTime = Clock::now();
+
+    int xCols = (yCols - 1) * hStride + wCols;
+    int xChls = wChls;
+
+    int uRows = yRows * yCols;
+    int uCols = wRows * wCols * wChls;
+    int chunksPerInput = (yRows + chunkRows - 1) / chunkRows;
+    int bufferCount = std::min(inputCount, 2);
+
+    // reshape the filters tensor W into a column-major matrix V
+    int vCols = wCount;
+    const ElementType* V = W;
+
+    // unrolls a chunk of an input into the part of the input's buffer that holds the chunk's rows of U, and returns the time it took
+    auto unrollChunk = [=](int chunk)
+    {
+        auto begin = Clock::now();
+        int input = chunk / chunksPerInput;
+        int yRowBegin = (chunk % chunksPerInput) * chunkRows;
+        int yRowCount = std::min(chunkRows, yRows - yRowBegin);
+        const ElementType* source = inputs[input] + yRowBegin * vStride * xCols * xChls;
+        ElementType* U = space + (input % bufferCount) * uRows * uCols + yRowBegin * yCols * uCols;
+        RowMajInputUnrollSerial(source, U, wRows, wCols, wChls, vStride, hStride, yRowCount, yCols, yRowCount * yCols, uCols);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+    };
+
+    // start the producer, unless the pool has no workers to run it concurrently
+    auto state = std::make_shared<PipelineState>(chunksPerInput * inputCount);
+    auto& pool = ThreadPool::GetShared();
+    if(pool.GetThreadCount() > 1)
+    {
+        pool.Submit([state, unrollChunk, chunksPerInput, bufferCount]()
+        {
+            auto unrollAndTime = [&](int chunk) { state->producerUnrollTime += unrollChunk(chunk); };
+            while(true)
+            {
+                auto result = state->TryUnrollNextChunk(chunksPerInput, bufferCount, unrollAndTime);
+                if(result == PipelineState::ClaimResult::finished)
+                {
+                    break;
+                }
+                if(result == PipelineState::ClaimResult::blocked)
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // the consumer multiplies the chunks in order, helping to unroll while the next chunk is not ready
+    long long consumerUnrollTime = 0;
+    long long gemmTime = 0;
+    auto consumerUnrollAndTime = [&](int chunk) { consumerUnrollTime += unrollChunk(chunk); };
+    for(int chunk = 0; chunk < state->chunkCount; ++chunk)
+    {
+        while(!state->isChunkUnrolled[chunk].load(std::memory_order_acquire))
+        {
+            if(state->TryUnrollNextChunk(chunksPerInput, bufferCount, consumerUnrollAndTime) != PipelineState::ClaimResult::claimed)
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        auto begin = Clock::now();
+        int input = chunk / chunksPerInput;
+        int yRowBegin = (chunk % chunksPerInput) * chunkRows;
+        int yRowCount = std::min(chunkRows, yRows - yRowBegin);
+        const ElementType* U = space + (input % bufferCount) * uRows * uCols + yRowBegin * yCols * uCols;
+        ElementType* Z = outputs[input] + yRowBegin * yCols * wCount;
+        Gemm(RowMaj, ColMaj, RowMaj, yRowCount * yCols, vCols, uCols, 1, U, V, 0, Z);
+        gemmTime += std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count();
+
+        // release the input's buffer to the producer after its last chunk is multiplied
+        if((chunk + 1) % chunksPerInput == 0)
+        {
+            state->multipliedInputCount.store(input + 1, std::memory_order_release);
+        }
+    }
+
+    if(statistics != nullptr)
+    {
+        // the producer adds the time of each chunk before it marks the chunk as unrolled, so all of its time is included
+        statistics->unrollTime = (consumerUnrollTime + state->producerUnrollTime.load()) * 1.0e-6;
+        statistics->gemmTime = gemmTime * 1.0e-6;
+        statistics->totalTime = std::chrono::duration<double, std::milli>(Clock::now() - startTime).count();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * unrolled input, software-pipelined: the output rows are split into chunks, a producer task on the shared thread pool unrolls
+//   the chunks in order, and the calling thread multiplies each chunk as soon as it is unrolled
+// * filters in filter-major order
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * yRows * yCols)
+//
+// W: 4-dimensional weights tensor in filter-major order
+// X: 3-dimensional input tensor in row-major order
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// chunkRows: number of output rows in each chunk (see GetPipelineChunkRows)
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * yRows * yCols)
+// statistics: optional pointer that receives the time spent in each stage
+template <typename ElementType>
+void Convolution(ConvProperties<FilterMajorFilters, PipelinedUnroll, RowMajorInput, RowMajorOutput, UnrolledInput> properties,
+    const ElementType* W,
+    const ElementType* X,
+    ElementType* Y,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    int chunkRows,
+    ElementType* space,
+    PipelineStatistics* statistics = nullptr)
+{
+    Convolution(properties, W, &X, &Y, 1, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, chunkRows, space, statistics);
+}
@@ -0,0 +1,121 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ProcessShardedConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ProcessSharding.h"
+#include "UnrolledInputConv_rI.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution, sharded across processes
+// * the output rows are split into one band per worker process, and each process computes its band with an unrolled-input
+//   convolution in its own private temporary space
+// * W, X and Y live in POSIX shared memory that all of the processes map, and each process reads its input rows, including the
+//   (wRows - vStride) halo rows shared with the next band, directly from the shared X
+// * with more than one NUMA node, the workers are spread over the nodes, so the convolution can use the memory bandwidth of
+//   every socket while each process only touches its own band of the output
+// * filters in filter-major order
+// * input tensor in row-major order
+// * output tensor in row-major order
+//
+// The worker processes are forked once, when the object is constructed, and live until it is destroyed. Fork the workers before
+// starting other threads that hold locks, and write the filters and inputs directly to GetFilters() and GetInput() to avoid
+// copying them.
+template <typename ElementType>
+class ProcessShardedConvolution
+{
+public:
+    // processCount: number of worker processes
+    // wCount: number of filters in W
+    // wRows: number of rows in each filter in W
+    // wCols: number of columns in each filter in W
+    // wChls: number of channels in each filter in W
+    // vStride: vertical stride
+    // hStride: horizontal stride
+    // yRows: number of rows in the output tensor Y
+    // yCols: number of columns in the output tensor Y
+    ProcessShardedConvolution(int processCount, int wCount, int wRows, int wCols, int wChls, int vStride, int hStride, int yRows, int yCols) :
+        _wCount(wCount), _wRows(wRows), _wCols(wCols), _wChls(wChls), _vStride(vStride), _hStride(hStride), _yRows(yRows), _yCols(yCols),
+        _processCount(std::max(1, std::min(processCount, yRows))),
+        _filters(sizeof(ElementType) * wCount * wRows * wCols * wChls),
+        _input(sizeof(ElementType) * ((yRows - 1) * vStride + wRows) * ((yCols - 1) * hStride + wCols) * wChls),
+        _output(sizeof(ElementType) * yRows * yCols * wCount),
+        _workers(_processCount, [this](int index) { RunShard(index); })
+    {}
+
+    ProcessShardedConvolution(const ProcessShardedConvolution&) = delete;
+    ProcessShardedConvolution& operator=(const ProcessShardedConvolution&) = delete;
+
+    // gets the 4-dimensional weights tensor W in filter-major order, in shared memory
+    ElementType* GetFilters() { return static_cast<ElementType*>(_filters.Data()); }
+
+    // gets the 3-dimensional input tensor X in row-major order (including any padding), in shared memory
+    ElementType* GetInput() { return static_cast<ElementType*>(_input.Data()); }
+
+    // gets the 3-dimensional output tensor Y in row-major order, in shared memory
+    const ElementType* GetOutput() const { return static_cast<const ElementType*>(_output.Data()); }
+
+    // gets the number of worker processes
+    int GetProcessCount() const { return _processCount; }
+
+    // computes Y from the current contents of W and X, and returns when every worker has finished its band
+    void Run() { _workers.Run(); }
+
+private:
+    int GetBandBegin(int index) const { return (int)((long long)index * _yRows / _processCount); }
+
+    // called in the worker process
+    void RunShard(int index)
+    {
+        int xCols = (_yCols - 1) * _hStride + _wCols;
+        int xChls = _wChls;
+        int uCols = _wRows * _wCols * _wChls;
+
+        int yRowBegin = GetBandBegin(index);
+        int yRowCount = GetBandBegin(index + 1) - yRowBegin;
+        int uRows = yRowCount * _yCols;
+
+        // the temporary space is allocated by the worker, on its own NUMA node, and BLAS uses this process's share of the processors
+        if(_space.empty())
+        {
+            _space.resize(uRows * uCols);
+            SetBlasThreadCount(std::max(1, (int)std::thread::hardware_concurrency() / _processCount));
+        }
+
+        // unroll the input rows of the band, including its halo rows
+        const ElementType* source = GetInput() + yRowBegin * _vStride * xCols * xChls;
+        RowMajInputUnrollSerial(source, _space.data(), _wRows, _wCols, _wChls, _vStride, _hStride, yRowCount, _yCols, uRows, uCols);
+
+        // reshape the filters tensor W into a column-major matrix V, and multiply into the rows of the output that belong to the band
+        const ElementType* V = GetFilters();
+        ElementType* Z = static_cast<ElementType*>(_output.Data()) + yRowBegin * _yCols * _wCount;
+        Gemm(RowMaj, ColMaj, RowMaj, uRows, _wCount, uCols, 1, _space.data(), V, 0, Z);
+    }
+
+    int _wCount;
+    int _wRows;
+    int _wCols;
+    int _wChls;
+    int _vStride;
+    int _hStride;
+    int _yRows;
+    int _yCols;
+    int _processCount;
+
+    SharedMemoryRegion _filters;
+    SharedMemoryRegion _input;
+    SharedMemoryRegion _output;
+    std::vector<ElementType> _space;
+
+    // constructed last, so the workers are forked after the shared memory is mapped
+    WorkerProcessGroup _workers;
+};
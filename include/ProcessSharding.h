@@ -0,0 +1,67 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ProcessSharding.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// A block of memory that is shared with the worker processes forked after it is created. The memory is a POSIX shared memory
+// object that is unlinked as soon as it is mapped, so it is released when the last process unmaps it, even if a process crashes.
+// On platforms other than Linux, the memory is an ordinary heap allocation.
+class SharedMemoryRegion
+{
+public:
+    // maps a zero-initialized region of the given size in bytes, and throws std::bad_alloc on failure
+    explicit SharedMemoryRegion(size_t size);
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    void* Data() const { return _data; }
+    size_t Size() const { return _size; }
+
+private:
+    void* _data;
+    size_t _size;
+};
+
+// A group of worker processes, forked when the group is constructed, that call work(index) each time Run is called, where index
+// is the worker index in [0, processCount). The workers are coordinated by process-shared semaphores in shared memory, so all of
+// the coordination is local to the host. If the computer has more than one NUMA node, worker i is pinned to the processors of
+// node (i % nodeCount). The workers must only use memory that is private or in a SharedMemoryRegion created before the group,
+// and must not use the shared thread pool, whose threads are not copied into the forked processes. On platforms other than
+// Linux, Run calls work(0), work(1), ... in the calling process.
+class WorkerProcessGroup
+{
+public:
+    WorkerProcessGroup(int processCount, std::function<void(int)> work);
+
+    // stops the workers and waits for them to exit
+    ~WorkerProcessGroup();
+
+    WorkerProcessGroup(const WorkerProcessGroup&) = delete;
+    WorkerProcessGroup& operator=(const WorkerProcessGroup&) = delete;
+
+    // gets the number of worker processes
+    int GetProcessCount() const { return _processCount; }
+
+    // Signals every worker to call work(index), and returns when all of them have finished. Throws std::runtime_error if a worker
+    // process has exited, in which case the group can no longer be used.
+    void Run();
+
+private:
+    void StopWorkers();
+
+    int _processCount;
+    std::function<void(int)> _work;
+    std::vector<int> _processIds;
+    SharedMemoryRegion _control;
+    bool _isBroken = false;
+};
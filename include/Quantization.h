@@ -0,0 +1,101 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     Quantization.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// the parameters of an affine quantization, where real = scale * (quantized - zeroPoint)
+struct QuantizationParameters
+{
+    float scale;
+    int zeroPoint;
+};
+
+// Computes asymmetric quantization parameters that map the range of the given values onto [qMin, qMax]. The range is extended to include zero, so that zero-padding is represented exactly.
+template <typename ElementType>
+QuantizationParameters GetQuantizationParameters(const ElementType* begin, int size, int qMin, int qMax)
+{
+    auto minmax = std::minmax_element(begin, begin + size);
+    float min = std::min(0.0f, (float)*minmax.first);
+    float max = std::max(0.0f, (float)*minmax.second);
+
+    if(max == min)
+    {
+        return { 1.0f, 0 };
+    }
+
+    float scale = (max - min) / (qMax - qMin);
+    int zeroPoint = (int)std::lround(qMin - min / scale);
+    zeroPoint = std::max(qMin, std::min(qMax, zeroPoint));
+    return { scale, zeroPoint };
+}
+
+// Computes symmetric quantization parameters (zero point equals zero) that map the range of the given values onto [-127, 127]
+template <typename ElementType>
+QuantizationParameters GetSymmetricQuantizationParameters(const ElementType* begin, int size)
+{
+    float maxAbs = 0;
+    for(int i = 0; i < size; ++i)
+    {
+        maxAbs = std::max(maxAbs, std::abs((float)begin[i]));
+    }
+    return { maxAbs > 0 ? maxAbs / 127 : 1.0f, 0 };
+}
+
+// Quantizes a single value
+template <typename QuantizedType>
+QuantizedType Quantize(float value, QuantizationParameters parameters)
+{
+    const int qMin = std::numeric_limits<QuantizedType>::min();
+    const int qMax = std::numeric_limits<QuantizedType>::max();
+    int quantized = (int)std::lround(value / parameters.scale) + parameters.zeroPoint;
+    return (QuantizedType)std::max(qMin, std::min(qMax, quantized));
+}
+
+// Quantizes an array of values
+template <typename ElementType, typename QuantizedType>
+void Quantize(const ElementType* source, QuantizedType* target, int size, QuantizationParameters parameters)
+{
+    for(int i = 0; i < size; ++i)
+    {
+        target[i] = Quantize<QuantizedType>((float)source[i], parameters);
+    }
+}
+
+// Dequantizes an array of values
+template <typename QuantizedType, typename ElementType>
+void Dequantize(const QuantizedType* source, ElementType* target, int size, QuantizationParameters parameters)
+{
+    for(int i = 0; i < size; ++i)
+    {
+        target[i] = (ElementType)(parameters.scale * ((int)source[i] - parameters.zeroPoint));
+    }
+}
+
+// Quantizes a filter-major filter tensor to 8-bit signed integers with symmetric scales
+// W: 4-dimensional weights tensor in filter-major order
+// WQ: 4-dimensional quantized weights tensor in filter-major order
+// wScales: array of wCount quantization scales, one per filter
+// wCount: number of filters in W
+// wSize: number of elements in each filter (wRows * wCols * wChls)
+// perChannel: if true, each filter (output channel) gets its own scale, otherwise all filters share one scale
+template <typename ElementType>
+void QuantizeFilters(const ElementType* W, int8_t* WQ, float* wScales, int wCount, int wSize, bool perChannel)
+{
+    auto tensorParameters = GetSymmetricQuantizationParameters(W, wCount * wSize);
+    for(int filter = 0; filter < wCount; ++filter)
+    {
+        const ElementType* source = W + filter * wSize;
+        auto parameters = perChannel ? GetSymmetricQuantizationParameters(source, wSize) : tensorParameters;
+        Quantize(source, WQ + filter * wSize, wSize, parameters);
+        wScales[filter] = parameters.scale;
+    }
+}
@@ -0,0 +1,98 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     QuantizedUnrolledInputConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ConvProperties.h"
+#include "Quantization.h"
+#include "UnrolledInputConv_rI.h"
+
+#include <cassert>
+#include <cstdint>
+#include <numeric>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * 8-bit quantized input, filters and output, with 32-bit integer accumulation
+// * unrolled input
+// * filters in filter-major order, with one quantization scale per filter (per-channel) or a shared scale (per-tensor)
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * yRows * yCols) bytes and (yRows * yCols * wCount + wCount) 32-bit integers
+//
+// W: 4-dimensional quantized weights tensor in filter-major order, with symmetric quantization (zero point equals zero)
+// wScales: array of wCount quantization scales, one per filter
+// X: 3-dimensional quantized input tensor in row-major order
+// xParameters: quantization parameters of X
+// Y: 3-dimensional quantized output tensor in row-major order
+// yParameters: quantization parameters of Y
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * yRows * yCols)
+// accumulators: pointer to temporary space of size at least (yRows * yCols * wCount + wCount)
+inline void Convolution(ConvProperties<FilterMajorFilters, QuantizedInt8, RowMajorInput, RowMajorOutput, UnrolledInput>,
+    const int8_t* W,
+    const float* wScales,
+    const uint8_t* X,
+    QuantizationParameters xParameters,
+    int8_t* Y,
+    QuantizationParameters yParameters,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    uint8_t* space,
+    int32_t* accumulators)
+{
+    // use temp space to store the unrolled input matrix U in row-major order
+    int uRows = yRows * yCols;
+    int uCols = wRows * wCols * wChls;
+    uint8_t* U = space;
+
+    // unroll the row-major input, which moves a quarter of the bytes moved by the float unroll
+    RowMajInputUnroll(X, U, wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+
+    // reshape the filters tensor W into a column-major matrix V
+    int vCols = wCount;
+    const int8_t* V = W;
+
+    // use temp space to store the 32-bit output matrix Z in row-major order
+    int32_t* Z = accumulators;
+
+    // integer matrix-matrix multiply
+    Gemm(RowMaj, ColMaj, RowMaj, uRows, vCols, uCols, U, V, Z);
+
+    // the input zero point contributes xZeroPoint * (sum of filter weights) to each accumulator
+    int32_t* wSums = accumulators + uRows * vCols;
+    for(int filter = 0; filter < wCount; ++filter)
+    {
+        const int8_t* begin = V + filter * uCols;
+        wSums[filter] = std::accumulate(begin, begin + uCols, (int32_t)0);
+    }
+
+    // requantize the 32-bit accumulators to the 8-bit output
+    for(int zRow = 0; zRow < uRows; ++zRow)
+    {
+        for(int filter = 0; filter < wCount; ++filter)
+        {
+            int32_t accumulator = Z[zRow * vCols + filter] - xParameters.zeroPoint * wSums[filter];
+            float value = xParameters.scale * wScales[filter] * accumulator;
+            Y[zRow * vCols + filter] = Quantize<int8_t>(value, yParameters);
+        }
+    }
+}
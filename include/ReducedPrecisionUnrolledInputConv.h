@@ -0,0 +1,186 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ReducedPrecisionUnrolledInputConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ConvProperties.h"
+#include "HalfPrecision.h"
+#include "Tensor.h"
+#include "UnrolledInputConv_cI.h"
+#include "UnrolledInputConv_rI.h"
+
+#include <algorithm>
+
+// size in bytes of the float panels of the unrolled input and the output that each matrix multiplication reads and writes, chosen to
+// fit in a typical per-core L2 cache
+const int reducedPrecisionPanelCacheSize = 1 << 18;
+
+// smallest number of rows in a panel, so that each matrix multiplication is large enough to amortize packing the filters
+const int reducedPrecisionMinPanelRows = 64;
+
+// Gets the number of rows of the unrolled input that are converted to float and multiplied at a time
+inline int GetReducedPrecisionPanelRows(int uRows, int uCols, int wCount)
+{
+    int panelRows = reducedPrecisionPanelCacheSize / ((uCols + wCount) * (int)sizeof(float));
+    return std::min(uRows, std::max(reducedPrecisionMinPanelRows, panelRows));
+}
+
+// Gets the size of the float panel space: one panel of the unrolled input and one panel of the output
+inline int GetReducedPrecisionPanelSpaceSize(int uRows, int uCols, int wCount)
+{
+    return GetReducedPrecisionPanelRows(uRows, uCols, wCount) * (uCols + wCount);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * input, unrolled input and output stored in a 16-bit floating point type (Float16 or BFloat16)
+// * float filters and float accumulation, on panels of rows of the unrolled input that are converted to float just before each
+//   matrix multiplication, and whose float output is converted to the storage type right after it
+// * unrolled input
+// * filters in filter-major order
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * yRows * yCols) in the storage type, and panel space of size
+//   GetReducedPrecisionPanelSpaceSize(yRows * yCols, wRows * wCols * wChls, wCount) floats
+//
+// W: 4-dimensional float weights tensor in filter-major order
+// X: 3-dimensional input tensor in row-major order
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * yRows * yCols)
+// panelSpace: pointer to temporary space of size at least GetReducedPrecisionPanelSpaceSize(yRows * yCols, wRows * wCols * wChls, wCount)
+template <typename StorageType>
+void Convolution(ConvProperties<FilterMajorFilters, ReducedPrecisionStorage, RowMajorInput, RowMajorOutput, UnrolledInput>,
+    const float* W,
+    const StorageType* X,
+    StorageType* Y,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    StorageType* space,
+    float* panelSpace)
+{
+    // use temp space to store the unrolled input matrix U in row-major order, in the storage type
+    int uRows = yRows * yCols;
+    int uCols = wRows * wCols * wChls;
+    StorageType* U = space;
+
+    // unroll the row-major input
+    RowMajInputUnroll(X, U, wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+
+    // reshape the filters tensor W into a column-major matrix V
+    int vCols = wCount;
+    const float* V = W;
+
+    // use panel space to store a float panel P of rows of U and the float output Z of the panel, both in row-major order
+    int panelRows = GetReducedPrecisionPanelRows(uRows, uCols, wCount);
+    float* P = panelSpace;
+    float* Z = panelSpace + panelRows * uCols;
+
+    for(int panelBegin = 0; panelBegin < uRows; panelBegin += panelRows)
+    {
+        int rowCount = std::min(panelRows, uRows - panelBegin);
+
+        // convert the rows of the panel to float, which are contiguous in the row-major U
+        ConvertToFloat(U + panelBegin * uCols, P, rowCount * uCols);
+
+        // matrix-matrix multiply
+        Gemm(RowMaj, ColMaj, RowMaj, rowCount, vCols, uCols, 1, P, V, 0, Z);
+
+        // convert the output rows of the panel to the storage type
+        ConvertFromFloat(Z, Y + panelBegin * vCols, rowCount * vCols);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * supports only horizontal stride of 1
+// * input, unrolled input and output stored in a 16-bit floating point type (Float16 or BFloat16)
+// * float filters and float accumulation, on panels of rows of the unrolled input that are converted to float just before each
+//   matrix multiplication, and whose float output is converted to the storage type right after it
+// * unrolled input
+// * filters in filter-major order
+// * input tensor in channel-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * yRows * yCols) in the storage type, and panel space of size
+//   GetReducedPrecisionPanelSpaceSize(yRows * yCols, wRows * wCols * wChls, wCount) floats
+//
+// W: 4-dimensional float weights tensor in filter-major order
+// X: 3-dimensional input tensor in channel-major order
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * yRows * yCols)
+// panelSpace: pointer to temporary space of size at least GetReducedPrecisionPanelSpaceSize(yRows * yCols, wRows * wCols * wChls, wCount)
+template <typename StorageType>
+void Convolution(ConvProperties<ChannelMajorInput, FilterMajorFilters, ReducedPrecisionStorage, RowMajorOutput, UnitHorizontalStride, UnrolledInput>,
+    const float* W,
+    const StorageType* X,
+    StorageType* Y,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int yRows,
+    int yCols,
+    StorageType* space,
+    float* panelSpace)
+{
+    // use temp space to store the unrolled input matrix U in column-major order, in the storage type
+    int uRows = yRows * yCols;
+    int uCols = wRows * wCols * wChls;
+    StorageType* U = space;
+
+    // unroll the channel-major input
+    ChlMajInputUnroll(X, U, wRows, wCols, wChls, vStride, yRows, yCols, uRows, uCols);
+
+    // reshape the filters tensor W into a column-major matrix V
+    int vCols = wCount;
+    const float* V = W;
+
+    // use panel space to store a float panel P of rows of U in column-major order and the float output Z of the panel in row-major order
+    int panelRows = GetReducedPrecisionPanelRows(uRows, uCols, wCount);
+    float* P = panelSpace;
+    float* Z = panelSpace + panelRows * uCols;
+
+    for(int panelBegin = 0; panelBegin < uRows; panelBegin += panelRows)
+    {
+        int rowCount = std::min(panelRows, uRows - panelBegin);
+
+        // convert the rows of the panel to float, one column of U at a time
+        for(int uCol = 0; uCol < uCols; ++uCol)
+        {
+            const StorageType* source = U + uCol * uRows + panelBegin;
+            ConvertToFloat(source, P + uCol * rowCount, rowCount);
+        }
+
+        // matrix-matrix multiply
+        Gemm(ColMaj, ColMaj, RowMaj, rowCount, vCols, uCols, 1, P, V, 0, Z);
+
+        // convert the output rows of the panel to the storage type
+        ConvertFromFloat(Z, Y + panelBegin * vCols, rowCount * vCols);
+    }
+}
@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     SeparableFiltersConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "ConvProperties.h"
+#include "LowRankFilters.h"
+
+#include <algorithm>
+#include <cassert>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * separable filters, each spatial kernel is a sum of outer products of vertical and horizontal 1D filters (see LowRankFilters.h)
+// * a horizontal 1D pass followed by a vertical 1D pass, which costs about (wRows + wCols) * rank multiplies per tap instead of wRows * wCols
+// * input tensor in channel-major order
+// * output tensor in row-major order
+// * requires temporary space of size (xRows * yCols + yRows * yCols)
+//
+// W: low-rank filters
+// X: 3-dimensional input tensor in channel-major order
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// space: pointer to temporary space of size at least (xRows * yCols + yRows * yCols)
+template <typename ElementType>
+void Convolution(ConvProperties<ChannelMajorInput, RowMajorOutput, SeparableFilters>,
+    const LowRankFilters<ElementType>& W,
+    const ElementType* X,
+    ElementType* Y,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    ElementType* space)
+{
+    assert(W.wCount == wCount && W.wRows == wRows && W.wCols == wCols && W.wChls == wChls);
+
+    int xRows = (yRows - 1) * vStride + wRows;
+    int xCols = (yCols - 1) * hStride + wCols;
+
+    // use temp space to store the result of the horizontal pass H, and one output channel P
+    ElementType* H = space;
+    ElementType* P = space + xRows * yCols;
+
+    for(int filter = 0; filter < wCount; ++filter)
+    {
+        std::fill(P, P + yRows * yCols, ElementType(0));
+
+        for(int wChl = 0; wChl < wChls; ++wChl)
+        {
+            const ElementType* XChl = X + wChl * xRows * xCols;
+            for(int t = 0; t < W.rank; ++t)
+            {
+                int component = (filter * wChls + wChl) * W.rank + t;
+                const ElementType* vertical = W.vertical.data() + component * wRows;
+                const ElementType* horizontal = W.horizontal.data() + component * wCols;
+
+                // horizontal pass, over every input row
+                for(int xRow = 0; xRow < xRows; ++xRow)
+                {
+                    ElementType* target = H + xRow * yCols;
+                    std::fill(target, target + yCols, ElementType(0));
+                    for(int wCol = 0; wCol < wCols; ++wCol)
+                    {
+                        ElementType weight = horizontal[wCol];
+                        const ElementType* source = XChl + xRow * xCols + wCol;
+                        for(int yCol = 0; yCol < yCols; ++yCol)
+                        {
+                            target[yCol] += weight * source[yCol * hStride];
+                        }
+                    }
+                }
+
+                // vertical pass, accumulated into the output channel
+                for(int yRow = 0; yRow < yRows; ++yRow)
+                {
+                    ElementType* target = P + yRow * yCols;
+                    for(int wRow = 0; wRow < wRows; ++wRow)
+                    {
+                        ElementType weight = vertical[wRow];
+                        const ElementType* source = H + (yRow * vStride + wRow) * yCols;
+                        for(int yCol = 0; yCol < yCols; ++yCol)
+                        {
+                            target[yCol] += weight * source[yCol];
+                        }
+                    }
+                }
+            }
+        }
+
+        // copy the output channel into the row-major output tensor
+        for(int i = 0; i < yRows * yCols; ++i)
+        {
+            Y[i * wCount + filter] = P[i];
+        }
+    }
+}
@@ -0,0 +1,298 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     SmallChannelConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "ConvProperties.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+// number of filters whose accumulators are held in registers at once (two 4-wide SSE registers of floats)
+const int smallChannelFilterBlock = 8;
+
+// number of output columns whose accumulators are held in registers at once; with smallChannelFilterBlock, the accumulators use 12
+// of the 16 SSE registers, which leaves room for the weights and the broadcast input element
+const int smallChannelColumnBlock = 6;
+
+// Helper function that computes a block of colCount adjacent output pixels and smallChannelFilterBlock filters, where the number of
+// channels, the number of columns, and the number of filters are compile-time constants so that the innermost loop over filters is
+// fully unrolled and vectorized. The filter size is also a compile-time constant if fixedRows and fixedCols are positive, and is
+// given by wRows and wCols otherwise.
+template <int fixedRows, int fixedCols, int wChls, int colCount, typename ElementType>
+void SmallChannelBlock(const ElementType* V, 
+    const ElementType* X, 
+    ElementType* Y, 
+    int vCols,
+    int wCount, 
+    int filterCount, 
+    int wRows, 
+    int wCols, 
+    int xCols, 
+    int hStride)
+{
+    const int rows = fixedRows > 0 ? fixedRows : wRows;
+    const int cols = fixedCols > 0 ? fixedCols : wCols;
+    ElementType accumulators[colCount][smallChannelFilterBlock] = {};
+
+    for(int wRow = 0; wRow < rows; ++wRow)
+    {
+        for(int wCol = 0; wCol < cols; ++wCol)
+        {
+            const ElementType* source = X + (wRow * xCols + wCol) * wChls;
+            const ElementType* weights = V + (wRow * cols + wCol) * wChls * vCols;
+            for(int wChl = 0; wChl < wChls; ++wChl)
+            {
+                for(int col = 0; col < colCount; ++col)
+                {
+                    ElementType x = source[col * hStride * wChls + wChl];
+                    for(int filter = 0; filter < smallChannelFilterBlock; ++filter)
+                    {
+                        accumulators[col][filter] += x * weights[wChl * vCols + filter];
+                    }
+                }
+            }
+        }
+    }
+
+    // store the accumulators of the filters that exist
+    for(int col = 0; col < colCount; ++col)
+    {
+        std::copy(accumulators[col], accumulators[col] + filterCount, Y + col * wCount);
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+// Helper function that multiplies one input element by the weights of smallChannelFilterBlock filters and adds the products to the
+// accumulators of one output column
+inline void SmallChannelMultiplyAdd(float x, __m128 weightsLow, __m128 weightsHigh, __m128& low, __m128& high)
+{
+    __m128 broadcast = _mm_set1_ps(x);
+    low = _mm_add_ps(low, _mm_mul_ps(broadcast, weightsLow));
+    high = _mm_add_ps(high, _mm_mul_ps(broadcast, weightsHigh));
+}
+
+// Helper function that stores the accumulators of the filters that exist in one output column
+inline void SmallChannelStore(__m128 low, __m128 high, float* Y, int filterCount)
+{
+    float accumulators[smallChannelFilterBlock];
+    _mm_storeu_ps(accumulators, low);
+    _mm_storeu_ps(accumulators + 4, high);
+    std::copy(accumulators, accumulators + filterCount, Y);
+}
+
+// Helper function that computes a block of colCount adjacent output pixels and smallChannelFilterBlock filters of float tensors
+// with SSE, using a named pair of accumulator registers for each column, since compilers keep an array of accumulators in memory
+// * up to smallChannelColumnBlock columns
+template <int fixedRows, int fixedCols, int wChls, int colCount>
+void SmallChannelBlock(const float* V, 
+    const float* X, 
+    float* Y, 
+    int vCols,
+    int wCount, 
+    int filterCount, 
+    int wRows, 
+    int wCols, 
+    int xCols, 
+    int hStride)
+{
+    static_assert(smallChannelFilterBlock == 8 && colCount >= 1 && colCount <= smallChannelColumnBlock, "the SSE block holds 8 filters and up to 6 columns");
+    const int rows = fixedRows > 0 ? fixedRows : wRows;
+    const int cols = fixedCols > 0 ? fixedCols : wCols;
+    int step = hStride * wChls;
+
+    __m128 low0 = _mm_setzero_ps(), low1 = low0, low2 = low0, low3 = low0, low4 = low0, low5 = low0;
+    __m128 high0 = low0, high1 = low0, high2 = low0, high3 = low0, high4 = low0, high5 = low0;
+    for(int wRow = 0; wRow < rows; ++wRow)
+    {
+        for(int wCol = 0; wCol < cols; ++wCol)
+        {
+            const float* source = X + (wRow * xCols + wCol) * wChls;
+            const float* weights = V + (wRow * cols + wCol) * wChls * vCols;
+            for(int wChl = 0; wChl < wChls; ++wChl)
+            {
+                __m128 weightsLow = _mm_loadu_ps(weights + wChl * vCols);
+                __m128 weightsHigh = _mm_loadu_ps(weights + wChl * vCols + 4);
+                const float* x = source + wChl;
+                SmallChannelMultiplyAdd(x[0], weightsLow, weightsHigh, low0, high0);
+                if(colCount > 1) SmallChannelMultiplyAdd(x[step], weightsLow, weightsHigh, low1, high1);
+                if(colCount > 2) SmallChannelMultiplyAdd(x[2 * step], weightsLow, weightsHigh, low2, high2);
+                if(colCount > 3) SmallChannelMultiplyAdd(x[3 * step], weightsLow, weightsHigh, low3, high3);
+                if(colCount > 4) SmallChannelMultiplyAdd(x[4 * step], weightsLow, weightsHigh, low4, high4);
+                if(colCount > 5) SmallChannelMultiplyAdd(x[5 * step], weightsLow, weightsHigh, low5, high5);
+            }
+        }
+    }
+
+    SmallChannelStore(low0, high0, Y, filterCount);
+    if(colCount > 1) SmallChannelStore(low1, high1, Y + wCount, filterCount);
+    if(colCount > 2) SmallChannelStore(low2, high2, Y + 2 * wCount, filterCount);
+    if(colCount > 3) SmallChannelStore(low3, high3, Y + 3 * wCount, filterCount);
+    if(colCount > 4) SmallChannelStore(low4, high4, Y + 4 * wCount, filterCount);
+    if(colCount > 5) SmallChannelStore(low5, high5, Y + 5 * wCount, filterCount);
+}
+#endif
+
+// Helper function that runs the convolution with a compile-time number of channels, and a compile-time filter size if fixedRows
+// and fixedCols are positive
+template <int fixedRows, int fixedCols, int wChls, typename ElementType>
+void SmallChannelConvolution(const ElementType* V, 
+    const ElementType* X, 
+    ElementType* Y, 
+    int vCols,
+    int wCount, 
+    int wRows, 
+    int wCols, 
+    int vStride, 
+    int hStride, 
+    int yRows, 
+    int yCols)
+{
+    int xCols = (yCols - 1) * hStride + wCols;
+
+    for(int yRow = 0; yRow < yRows; ++yRow)
+    {
+        for(int filter = 0; filter < wCount; filter += smallChannelFilterBlock)
+        {
+            const ElementType* weights = V + filter;
+            const ElementType* source = X + yRow * vStride * xCols * wChls;
+            ElementType* target = Y + yRow * yCols * wCount + filter;
+            int filterCount = std::min(smallChannelFilterBlock, wCount - filter);
+
+            // full blocks of columns, followed by one block of the remaining columns
+            int yCol = 0;
+            for(; yCol + smallChannelColumnBlock <= yCols; yCol += smallChannelColumnBlock)
+            {
+                SmallChannelBlock<fixedRows, fixedCols, wChls, smallChannelColumnBlock>(weights, source + yCol * hStride * wChls, target + yCol * wCount, vCols, wCount, filterCount, wRows, wCols, xCols, hStride);
+            }
+
+            source += yCol * hStride * wChls;
+            target += yCol * wCount;
+            switch(yCols - yCol)
+            {
+            case 1:
+                SmallChannelBlock<fixedRows, fixedCols, wChls, 1>(weights, source, target, vCols, wCount, filterCount, wRows, wCols, xCols, hStride);
+                break;
+            case 2:
+                SmallChannelBlock<fixedRows, fixedCols, wChls, 2>(weights, source, target, vCols, wCount, filterCount, wRows, wCols, xCols, hStride);
+                break;
+            case 3:
+                SmallChannelBlock<fixedRows, fixedCols, wChls, 3>(weights, source, target, vCols, wCount, filterCount, wRows, wCols, xCols, hStride);
+                break;
+            case 4:
+                SmallChannelBlock<fixedRows, fixedCols, wChls, 4>(weights, source, target, vCols, wCount, filterCount, wRows, wCols, xCols, hStride);
+                break;
+            case 5:
+                SmallChannelBlock<fixedRows, fixedCols, wChls, 5>(weights, source, target, vCols, wCount, filterCount, wRows, wCols, xCols, hStride);
+                break;
+            }
+        }
+    }
+}
+
+// Helper function that dispatches to the instantiation for square filters of the given size (or a runtime filter size, if 0)
+template <int wSize, typename ElementType>
+void SmallChannelConvolutionSquare(const ElementType* V, 
+    const ElementType* X, 
+    ElementType* Y, 
+    int vCols,
+    int wCount, 
+    int wRows, 
+    int wCols, 
+    int wChls, 
+    int vStride, 
+    int hStride, 
+    int yRows, 
+    int yCols)
+{
+    switch(wChls)
+    {
+    case 1:
+        SmallChannelConvolution<wSize, wSize, 1>(V, X, Y, vCols, wCount, wRows, wCols, vStride, hStride, yRows, yCols);
+        break;
+    case 2:
+        SmallChannelConvolution<wSize, wSize, 2>(V, X, Y, vCols, wCount, wRows, wCols, vStride, hStride, yRows, yCols);
+        break;
+    case 3:
+        SmallChannelConvolution<wSize, wSize, 3>(V, X, Y, vCols, wCount, wRows, wCols, vStride, hStride, yRows, yCols);
+        break;
+    case 4:
+        SmallChannelConvolution<wSize, wSize, 4>(V, X, Y, vCols, wCount, wRows, wCols, vStride, hStride, yRows, yCols);
+        break;
+    default:
+        throw std::invalid_argument("SmallChannelCount supports only 1 to 4 channels");
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * supports only 1 to 4 input channels, typical of grayscale and RGB input layers, and throws std::invalid_argument otherwise
+// * direct convolution, vectorized across filters and computed in blocks of adjacent output columns, with the filter bank in L1
+// * compile-time filter sizes for 3x3, 5x5 and 7x7 filters, and SSE accumulator registers for float tensors
+// * filters in row-major order
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * vCols), where vCols is wCount rounded up to a multiple of smallChannelFilterBlock
+//
+// W: 4-dimensional weights tensor in row-major order
+// X: 3-dimensional input tensor in row-major order
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W, between 1 and 4
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * vCols)
+template <typename ElementType>
+void Convolution(ConvProperties<RowMajorFilters, RowMajorInput, RowMajorOutput, SmallChannelCount>,
+    const ElementType* W, 
+    const ElementType* X, 
+    ElementType* Y, 
+    int wCount, 
+    int wRows, 
+    int wCols, 
+    int wChls, 
+    int vStride, 
+    int hStride, 
+    int yRows, 
+    int yCols,
+    ElementType* space)
+{
+    // use temp space to store the row-major filter matrix V, with zero columns that pad the number of filters to whole blocks
+    int vRows = wRows * wCols * wChls;
+    int vCols = (wCount + smallChannelFilterBlock - 1) / smallChannelFilterBlock * smallChannelFilterBlock;
+    ElementType* V = space;
+    for(int vRow = 0; vRow < vRows; ++vRow)
+    {
+        std::copy(W + vRow * wCount, W + (vRow + 1) * wCount, V + vRow * vCols);
+        std::fill(V + vRow * vCols + wCount, V + (vRow + 1) * vCols, ElementType(0));
+    }
+
+    // compile-time filter sizes for the common square filters, and a runtime filter size otherwise
+    int wSize = wRows == wCols ? wRows : 0;
+    switch(wSize)
+    {
+    case 3:
+        SmallChannelConvolutionSquare<3>(V, X, Y, vCols, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+        break;
+    case 5:
+        SmallChannelConvolutionSquare<5>(V, X, Y, vCols, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+        break;
+    case 7:
+        SmallChannelConvolutionSquare<7>(V, X, Y, vCols, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+        break;
+    default:
+        SmallChannelConvolutionSquare<0>(V, X, Y, vCols, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+    }
+}
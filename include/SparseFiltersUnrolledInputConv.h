@@ -0,0 +1,70 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     SparseFiltersUnrolledInputConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "ConvProperties.h"
+#include "SparseMatrix.h"
+#include "UnrolledInputConv_rI.h"
+
+#include <stdexcept>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * sparse filters, in compressed sparse row or block-sparse format
+// * unrolled input 
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * yRows * yCols)
+// * throws std::invalid_argument if W does not have wRows * wCols * wChls rows and wCount columns
+//
+// W: sparse filter matrix (CsrMatrix or BlockSparseMatrix) with wRows * wCols * wChls rows and wCount columns, obtained from a
+//    filter-major weights tensor viewed as a column-major matrix
+// X: 3-dimensional input tensor in row-major order
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * yRows * yCols)
+template <typename SparseMatrixType, typename ElementType>
+void Convolution(ConvProperties<RowMajorInput, RowMajorOutput, SparseFilters, UnrolledInput>,
+    const SparseMatrixType& W,
+    const ElementType* X,
+    ElementType* Y,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    ElementType* space)
+{
+    // use temp space to store the unrolled input matrix U in row-major order
+    int uRows = yRows * yCols;
+    int uCols = wRows * wCols * wChls;
+    ElementType* U = space;
+
+    // unroll the row-major input
+    RowMajInputUnroll(X, U, wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+
+    // the sparse filter matrix V has one row per unrolled input column and one column per filter
+    const SparseMatrixType& V = W;
+    if(V.rows != uCols || V.cols != wCount)
+    {
+        throw std::invalid_argument("the sparse filter matrix does not match the filter shape");
+    }
+
+    // dense-sparse matrix-matrix multiply, where the output Z is the row-major output tensor Y
+    Gemm(uRows, U, V, Y);
+}
@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     SparseMatrix.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "Tensor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//
+// Sparse matrix formats, used to store pruned filters. A CsrMatrix stores each nonzero element with its column index, row by row
+// (compressed sparse row). A BlockSparseMatrix stores each block of blockRows x blockCols elements that contains a nonzero, with the
+// column index of the block, block row by block row; its blocks are stored in row-major order and are zero-padded at the matrix edges.
+//
+
+template <typename ElementType>
+struct CsrMatrix
+{
+    int rows = 0;
+    int cols = 0;
+    std::vector<int> rowOffsets;        // rows + 1 offsets into columnIndices and values
+    std::vector<int> columnIndices;     // column index of each nonzero
+    std::vector<ElementType> values;    // value of each nonzero
+};
+
+template <typename ElementType, int blockRows, int blockCols>
+struct BlockSparseMatrix
+{
+    int rows = 0;
+    int cols = 0;
+    std::vector<int> blockRowOffsets;   // (number of block rows) + 1 offsets into blockColumnIndices
+    std::vector<int> blockColumnIndices;// block column index of each stored block
+    std::vector<ElementType> values;    // blockRows * blockCols values of each stored block
+};
+
+// Converts a dense matrix to a CsrMatrix
+// M: pointer to the dense matrix
+// rows: number of rows in M
+// cols: number of columns in M
+// order: memory order of M
+template <typename ElementType>
+CsrMatrix<ElementType> GetCsrMatrix(const ElementType* M, int rows, int cols, MatrixOrder order)
+{
+    auto MMat = MatrixConstInterface<ElementType>(M, { rows, cols }, order);
+
+    CsrMatrix<ElementType> sparse;
+    sparse.rows = rows;
+    sparse.cols = cols;
+    sparse.rowOffsets.push_back(0);
+    for(int row = 0; row < rows; ++row)
+    {
+        for(int col = 0; col < cols; ++col)
+        {
+            ElementType value = MMat({row, col});
+            if(value != 0)
+            {
+                sparse.columnIndices.push_back(col);
+                sparse.values.push_back(value);
+            }
+        }
+        sparse.rowOffsets.push_back((int)sparse.values.size());
+    }
+    return sparse;
+}
+
+// Converts a dense matrix to a BlockSparseMatrix
+// M: pointer to the dense matrix
+// rows: number of rows in M
+// cols: number of columns in M
+// order: memory order of M
+template <int blockRows, int blockCols, typename ElementType>
+BlockSparseMatrix<ElementType, blockRows, blockCols> GetBlockSparseMatrix(const ElementType* M, int rows, int cols, MatrixOrder order)
+{
+    auto MMat = MatrixConstInterface<ElementType>(M, { rows, cols }, order);
+
+    BlockSparseMatrix<ElementType, blockRows, blockCols> sparse;
+    sparse.rows = rows;
+    sparse.cols = cols;
+    sparse.blockRowOffsets.push_back(0);
+    for(int row0 = 0; row0 < rows; row0 += blockRows)
+    {
+        for(int col0 = 0; col0 < cols; col0 += blockCols)
+        {
+            // copy the block, with zero-padding beyond the matrix edges
+            ElementType block[blockRows * blockCols] = {};
+            bool isNonzero = false;
+            for(int i = 0; i < blockRows && row0 + i < rows; ++i)
+            {
+                for(int j = 0; j < blockCols && col0 + j < cols; ++j)
+                {
+                    block[i * blockCols + j] = MMat({row0 + i, col0 + j});
+                    isNonzero = isNonzero || block[i * blockCols + j] != 0;
+                }
+            }
+
+            if(isNonzero)
+            {
+                sparse.blockColumnIndices.push_back(col0 / blockCols);
+                sparse.values.insert(sparse.values.end(), block, block + blockRows * blockCols);
+            }
+        }
+        sparse.blockRowOffsets.push_back((int)sparse.blockColumnIndices.size());
+    }
+    return sparse;
+}
+
+// Prunes a dense matrix in place, by setting to zero the given fraction of its blockRows x blockCols blocks that have the smallest
+// sum of absolute values (use 1 x 1 blocks for unstructured pruning)
+// M: pointer to the dense matrix
+// rows: number of rows in M
+// cols: number of columns in M
+// order: memory order of M
+// sparsity: fraction of blocks to prune, between 0 and 1
+template <typename ElementType>
+void PruneBlocks(ElementType* M, int rows, int cols, MatrixOrder order, int blockRows, int blockCols, double sparsity)
+{
+    auto MMat = MatrixInterface<ElementType>(M, { rows, cols }, order);
+    int gridRows = (rows + blockRows - 1) / blockRows;
+    int gridCols = (cols + blockCols - 1) / blockCols;
+
+    // calculate the magnitude of each block
+    std::vector<double> magnitudes(gridRows * gridCols);
+    for(int row = 0; row < rows; ++row)
+    {
+        for(int col = 0; col < cols; ++col)
+        {
+            magnitudes[(row / blockRows) * gridCols + col / blockCols] += std::abs((double)MMat({row, col}));
+        }
+    }
+
+    // find the magnitude threshold below which blocks are pruned
+    int pruneCount = (int)std::lround(sparsity * magnitudes.size());
+    if(pruneCount == 0)
+    {
+        return;
+    }
+    auto sorted = magnitudes;
+    std::nth_element(sorted.begin(), sorted.begin() + pruneCount - 1, sorted.end());
+    double threshold = sorted[pruneCount - 1];
+
+    // prune exactly pruneCount blocks, breaking ties in memory order
+    for(int block = 0; block < (int)magnitudes.size() && pruneCount > 0; ++block)
+    {
+        if(magnitudes[block] <= threshold)
+        {
+            int row0 = (block / gridCols) * blockRows;
+            int col0 = (block % gridCols) * blockCols;
+            for(int row = row0; row < std::min(row0 + blockRows, rows); ++row)
+            {
+                for(int col = col0; col < std::min(col0 + blockCols, cols); ++col)
+                {
+                    MMat({row, col}) = 0;
+                }
+            }
+            --pruneCount;
+        }
+    }
+}
+
+// number of rows of A and C that the sparse GEMMs process together: each nonzero of B is applied to a panel of this many rows
+// at once, and the panels are transposed so that the inner loop over the rows is contiguous and vectorized
+const int sparseGemmPanelRows = 32;
+
+// Copies rows [0, panelRows) of a row-major matrix with the given number of columns into a column-major panel of
+// sparseGemmPanelRows rows, with zeros in the rows beyond panelRows
+template <typename ElementType>
+void LoadSparseGemmPanel(const ElementType* M, int panelRows, int cols, ElementType* panel)
+{
+    for(int col = 0; col < cols; ++col)
+    {
+        for(int row = 0; row < sparseGemmPanelRows; ++row)
+        {
+            panel[col * sparseGemmPanelRows + row] = row < panelRows ? M[row * cols + col] : ElementType(0);
+        }
+    }
+}
+
+// Copies rows [0, panelRows) of a column-major panel of sparseGemmPanelRows rows into a row-major matrix
+template <typename ElementType>
+void StoreSparseGemmPanel(const ElementType* panel, int panelRows, int cols, ElementType* M)
+{
+    for(int row = 0; row < panelRows; ++row)
+    {
+        for(int col = 0; col < cols; ++col)
+        {
+            M[row * cols + col] = panel[col * sparseGemmPanelRows + row];
+        }
+    }
+}
+
+// sparse GEMM, with dense row-major A, sparse B, and dense row-major C (C = A * B)
+// m: number of rows in A and C
+template <typename ElementType>
+void Gemm(int m, const ElementType* A, const CsrMatrix<ElementType>& B, ElementType* C)
+{
+    int k = B.rows;
+    int n = B.cols;
+    std::vector<ElementType> APanel(k * sparseGemmPanelRows);
+    std::vector<ElementType> CPanel(n * sparseGemmPanelRows);
+    for(int i0 = 0; i0 < m; i0 += sparseGemmPanelRows)
+    {
+        int panelRows = std::min(sparseGemmPanelRows, m - i0);
+        LoadSparseGemmPanel(A + i0 * k, panelRows, k, APanel.data());
+        std::fill(CPanel.begin(), CPanel.end(), ElementType(0));
+
+        // scale column l of the A panel by each nonzero in row l of B, and add it to the matching column of the C panel
+        for(int l = 0; l < k; ++l)
+        {
+            const ElementType* a = APanel.data() + l * sparseGemmPanelRows;
+            for(int index = B.rowOffsets[l]; index < B.rowOffsets[l + 1]; ++index)
+            {
+                ElementType value = B.values[index];
+                ElementType* c = CPanel.data() + B.columnIndices[index] * sparseGemmPanelRows;
+                for(int row = 0; row < sparseGemmPanelRows; ++row)
+                {
+                    c[row] += value * a[row];
+                }
+            }
+        }
+
+        StoreSparseGemmPanel(CPanel.data(), panelRows, n, C + i0 * n);
+    }
+}
+
+// sparse GEMM, with dense row-major A, block-sparse B, and dense row-major C (C = A * B)
+// m: number of rows in A and C
+template <typename ElementType, int blockRows, int blockCols>
+void Gemm(int m, const ElementType* A, const BlockSparseMatrix<ElementType, blockRows, blockCols>& B, ElementType* C)
+{
+    int k = B.rows;
+    int n = B.cols;
+    int gridRows = (int)B.blockRowOffsets.size() - 1;
+
+    // the panels are padded to whole blocks, so that blocks at the matrix edges need no bounds checks
+    int paddedK = gridRows * blockRows;
+    int paddedN = (n + blockCols - 1) / blockCols * blockCols;
+    std::vector<ElementType> APanel(paddedK * sparseGemmPanelRows);
+    std::vector<ElementType> CPanel(paddedN * sparseGemmPanelRows);
+    for(int i0 = 0; i0 < m; i0 += sparseGemmPanelRows)
+    {
+        int panelRows = std::min(sparseGemmPanelRows, m - i0);
+        LoadSparseGemmPanel(A + i0 * k, panelRows, k, APanel.data());
+        std::fill(CPanel.begin(), CPanel.end(), ElementType(0));
+
+        for(int blockRow = 0; blockRow < gridRows; ++blockRow)
+        {
+            const ElementType* a = APanel.data() + blockRow * blockRows * sparseGemmPanelRows;
+            for(int index = B.blockRowOffsets[blockRow]; index < B.blockRowOffsets[blockRow + 1]; ++index)
+            {
+                ElementType* c = CPanel.data() + B.blockColumnIndices[index] * blockCols * sparseGemmPanelRows;
+                const ElementType* block = B.values.data() + index * blockRows * blockCols;
+
+                // the block bounds are compile-time constants, so the loops over the block are unrolled, each column of the C
+                // panel is loaded and stored once per block, and the loop over the rows is vectorized
+                for(int bj = 0; bj < blockCols; ++bj)
+                {
+                    for(int row = 0; row < sparseGemmPanelRows; ++row)
+                    {
+                        ElementType sum = c[bj * sparseGemmPanelRows + row];
+                        for(int bi = 0; bi < blockRows; ++bi)
+                        {
+                            sum += block[bi * blockCols + bj] * a[bi * sparseGemmPanelRows + row];
+                        }
+                        c[bj * sparseGemmPanelRows + row] = sum;
+                    }
+                }
+            }
+        }
+
+        StoreSparseGemmPanel(CPanel.data(), panelRows, n, C + i0 * n);
+    }
+}
@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     SpatiallyTiledUnrolledInputConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ConvProperties.h"
+#include "ThreadPool.h"
+#include "UnrolledInputConv_rI.h"
+
+#include <algorithm>
+
+// default size in bytes of the unrolled input of one band, chosen to fit in a typical per-core L2 cache
+const int spatialTilingCacheSize = 1 << 18;
+
+// Gets the number of output rows in each band, so that the unrolled input of a band fits in the given cache size
+inline int GetSpatialTilingBandRows(int wRows, int wCols, int wChls, int yRows, int yCols, int elementSize, int cacheSize = spatialTilingCacheSize)
+{
+    int bandRowSize = yCols * wRows * wCols * wChls * elementSize;
+    return std::max(1, std::min(yRows, cacheSize / bandRowSize));
+}
+
+// Gets the number of bands that are processed concurrently, each with its own slice of the temporary space
+inline int GetSpatialTilingSliceCount(int yRows, int bandRows)
+{
+    int bandCount = (yRows + bandRows - 1) / bandRows;
+    return std::min(bandCount, ThreadPool::GetShared().GetThreadCount());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * unrolled input, split into bands of output rows that are unrolled and multiplied independently on the shared thread pool,
+//   with BLAS restricted to a single thread
+// * each band reads its input rows, including the (wRows - vStride) halo rows shared with the next band, directly from X
+// * filters in filter-major order
+// * input tensor in row-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * bandRows * yCols * sliceCount), where sliceCount is given by GetSpatialTilingSliceCount
+//
+// W: 4-dimensional weights tensor in filter-major order
+// X: 3-dimensional input tensor in row-major order
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// hStride: horizontal stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// bandRows: number of output rows in each band (see GetSpatialTilingBandRows)
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * bandRows * yCols * sliceCount)
+template <typename ElementType>
+void Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, SpatialTiling, UnrolledInput>,
+    const ElementType* W,
+    const ElementType* X,
+    ElementType* Y,
+    int wCount,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride,
+    int hStride,
+    int yRows,
+    int yCols,
+    int bandRows,
+    ElementType* space)
+{
+    int xCols = (yCols - 1) * hStride + wCols;
+    int xChls = wChls;
+
+    int uCols = wRows * wCols * wChls;
+    int bandCount = (yRows + bandRows - 1) / bandRows;
+    int sliceCount = GetSpatialTilingSliceCount(yRows, bandRows);
+
+    // reshape the filters tensor W into a column-major matrix V
+    int vCols = wCount;
+    const ElementType* V = W;
+
+    // each slice of the temporary space processes the bands slice, slice + sliceCount, slice + 2 * sliceCount, ...
+    SingleThreadedBlasScope blasScope;
+    ThreadPool::GetShared().ParallelFor(0, sliceCount, 1, [&](int sliceBegin, int sliceEnd)
+    {
+        for(int slice = sliceBegin; slice < sliceEnd; ++slice)
+        {
+            ElementType* U = space + slice * bandRows * yCols * uCols;
+            for(int band = slice; band < bandCount; band += sliceCount)
+            {
+                int yRowBegin = band * bandRows;
+                int yRowCount = std::min(bandRows, yRows - yRowBegin);
+                int uRows = yRowCount * yCols;
+
+                // unroll the input rows of the band into this slice of the temporary space
+                const ElementType* source = X + yRowBegin * vStride * xCols * xChls;
+                RowMajInputUnrollSerial(source, U, wRows, wCols, wChls, vStride, hStride, yRowCount, yCols, uRows, uCols);
+
+                // multiply into the rows of the output matrix Z that belong to the band
+                ElementType* Z = Y + yRowBegin * yCols * wCount;
+                Gemm(RowMaj, ColMaj, RowMaj, uRows, vCols, uCols, 1, U, V, 0, Z);
+            }
+        }
+    });
+}
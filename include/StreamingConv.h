@@ -0,0 +1,107 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     StreamingConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+
+#include <algorithm>
+#include <vector>
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution of a stream of input rows
+// * the input is pushed one row at a time, and is kept in a ring buffer of the last wRows rows
+// * each output row is computed as soon as its last input row is pushed, by unrolling the wRows rows of the ring buffer into a
+//   single-row unrolled matrix and multiplying it by the filters
+// * memory is (wRows * xCols * wChls + yCols * wRows * wCols * wChls) elements, independent of the number of rows in the image
+// * filters in filter-major order
+// * input rows in row-major order (each row is xCols * wChls elements, including any left and right padding)
+// * output rows in row-major order (each row is yCols * wCount elements)
+//
+// Input row r completes output row (r - wRows + 1) / vStride whenever (r - wRows + 1) is a non-negative multiple of vStride, so each
+// pushed row produces at most one output row.
+template <typename ElementType>
+class StreamingConvolution
+{
+public:
+    // W: 4-dimensional weights tensor in filter-major order, which must remain valid while rows are pushed
+    // wCount: number of filters in W
+    // wRows: number of rows in each filter in W
+    // wCols: number of columns in each filter in W
+    // wChls: number of channels in each filter in W
+    // vStride: vertical stride
+    // hStride: horizontal stride
+    // xCols: number of columns in each input row
+    StreamingConvolution(const ElementType* W, int wCount, int wRows, int wCols, int wChls, int vStride, int hStride, int xCols) :
+        _W(W), _wCount(wCount), _wRows(wRows), _wCols(wCols), _wChls(wChls), _vStride(vStride), _hStride(hStride), _xCols(xCols),
+        _yCols((xCols - wCols) / hStride + 1),
+        _ring(wRows * xCols * wChls),
+        _U(_yCols * wRows * wCols * wChls)
+    {}
+
+    // gets the number of columns in each output row
+    int GetOutputCols() const { return _yCols; }
+
+    // gets the number of input rows pushed, and output rows produced, since construction or the last call to Reset
+    int GetInputRowCount() const { return _xRowCount; }
+    int GetOutputRowCount() const { return _yRowCount; }
+
+    // starts a new image
+    void Reset()
+    {
+        _xRowCount = 0;
+        _yRowCount = 0;
+    }
+
+    // Pushes the next input row. If the row completes an output row, writes it to yRow (yCols * wCount elements) and returns true.
+    bool PushRow(const ElementType* xRow, ElementType* yRow)
+    {
+        int xRowSize = _xCols * _wChls;
+        std::copy(xRow, xRow + xRowSize, _ring.data() + (_xRowCount % _wRows) * xRowSize);
+        ++_xRowCount;
+
+        // the output row whose last input row was just pushed, if any
+        int firstRow = _xRowCount - _wRows;
+        if(firstRow < 0 || firstRow % _vStride != 0)
+        {
+            return false;
+        }
+
+        // unroll the ring buffer into U, one row of U per output column, starting from the oldest row in the window
+        int uCols = _wRows * _wCols * _wChls;
+        int windowSize = _wCols * _wChls;
+        for(int i = 0; i < _wRows; ++i)
+        {
+            const ElementType* ringRow = _ring.data() + ((firstRow + i) % _wRows) * xRowSize;
+            for(int j = 0; j < _yCols; ++j)
+            {
+                const ElementType* source = ringRow + j * _hStride * _wChls;
+                std::copy(source, source + windowSize, _U.data() + j * uCols + i * windowSize);
+            }
+        }
+
+        // reshape the filters tensor W into a column-major matrix V, and multiply into the output row
+        Gemm(RowMaj, ColMaj, RowMaj, _yCols, _wCount, uCols, 1, _U.data(), _W, 0, yRow);
+        ++_yRowCount;
+        return true;
+    }
+
+private:
+    const ElementType* _W;
+    int _wCount;
+    int _wRows;
+    int _wCols;
+    int _wChls;
+    int _vStride;
+    int _hStride;
+    int _xCols;
+    int _yCols;
+    int _xRowCount = 0;
+    int _yRowCount = 0;
+    std::vector<ElementType> _ring;
+    std::vector<ElementType> _U;
+};
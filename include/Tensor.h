@@ -7,6 +7,8 @@
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include "Numa.h"
+
 #include <algorithm>
 #include <array>
 #include <cassert>
@@ -140,7 +142,7 @@ public:
     Tensor(IntTuple<degree> shape, IntTuple<degree> order);
 
 private:
-    std::vector<ElementType> _data;
+    NumaVector<ElementType> _data;
 };
 
 template <typename ElementType, int degree, typename RandomEngineType>
@@ -479,7 +481,7 @@ void TensorInterface<ElementType, degree>::Generate(GeneratorType generator, Int
 
 template <typename ElementType, int degree>
 Tensor<ElementType, degree>::Tensor(IntTuple<degree> shape, IntTuple<degree> order) :
-    TensorInterface<ElementType, degree>(nullptr, shape, order), _data(this->Size())
+    TensorInterface<ElementType, degree>(nullptr, shape, order), _data(this->Size(), ElementType{}) // zeroes the padding
 {
     this->_pData = _data.data();
 }
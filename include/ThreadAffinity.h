@@ -0,0 +1,33 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ThreadAffinity.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include <vector>
+
+// policies that assign the threads of a thread pool to logical processors
+enum class AffinityPolicy
+{
+    none,     // threads are not pinned and the operating system may migrate them
+    compact,  // consecutive threads fill the hyperthreads of a core, then the cores of a socket, then the next socket
+    scatter,  // consecutive threads are spread round-robin over the sockets, then over the cores of each socket
+    physical  // one thread per physical core, spread like compact, so hyperthreads never share a core
+};
+
+// gets the name of a policy, and parses a policy from its name (returns false if the name is not recognized)
+const char* GetAffinityPolicyName(AffinityPolicy policy);
+bool ParseAffinityPolicy(const char* name, AffinityPolicy& policy);
+
+// Gets the logical processors available to the process, in the order in which the given policy assigns them to threads.
+// Returns an empty list if the policy is none or thread affinity is not supported on this platform (other than Linux).
+std::vector<int> GetAffinityCpuOrder(AffinityPolicy policy);
+
+// gets the operating system identifier of the calling thread (or 0 if not supported)
+long GetCurrentThreadId();
+
+// pins the thread with the given identifier to a logical processor, and returns false on failure
+bool PinThread(long threadId, int cpu);
@@ -0,0 +1,148 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ThreadPool.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "ThreadAffinity.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A work-stealing thread pool that executes parallel loops over 1D and 2D ranges. Each thread owns a deque of tasks: a thread
+// that runs a range task splits it in half, pushes one half onto the back of its own deque and continues with the other half,
+// and idle threads steal the oldest (largest) tasks from the front of the deques of other threads. The calling thread
+// participates in each loop and keeps executing tasks while it waits, so loops can be nested without blocking threads, and a
+// pool with threadCount threads starts (threadCount - 1) workers. A waiting thread runs any queued task, including blocks of
+// unrelated loops and functions passed to Submit, so a loop can return later than its own blocks finish, by up to the length of
+// the longest such task.
+class ThreadPool
+{
+public:
+    // the body of a 2D loop, called as body(rowBegin, rowEnd, colBegin, colEnd)
+    using Body2D = std::function<void(int, int, int, int)>;
+
+    // constructs a pool with the given total number of threads, including the calling thread
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    // gets the pool shared by all parallel code paths, with one thread per hardware thread unless set otherwise
+    static ThreadPool& GetShared();
+
+    // Replaces the shared pool with a pool of the given total number of threads, pinned with the same affinity policy. Must not be
+    // called while the shared pool is running a loop.
+    static void SetSharedThreadCount(int threadCount);
+
+    // gets the total number of threads, including the calling thread
+    int GetThreadCount() const { return (int)_workers.size() + 1; }
+
+    // Pins the calling thread (thread 0) and the workers (threads 1 and up) to logical processors in the order given by the
+    // policy, wrapping around if there are more threads than processors. Returns false if pinning is not supported or failed.
+    bool SetAffinity(AffinityPolicy policy);
+
+    // gets the current affinity policy, and the logical processor of each thread (empty if the threads are not pinned)
+    AffinityPolicy GetAffinityPolicy() const { return _affinityPolicy; }
+    const std::vector<int>& GetAffinityCpus() const { return _affinityCpus; }
+
+    // Calls body(first, last) on disjoint subranges that cover [begin, end), in parallel, and returns when all calls have finished.
+    // The subranges are split at multiples of grainSize from begin, so each subrange has a multiple of grainSize elements, except
+    // the last one, which ends at end and can be shorter than grainSize.
+    void ParallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body);
+
+    // Calls body(rowBegin, rowEnd, colBegin, colEnd) on disjoint blocks that cover [rowBegin, rowEnd) x [colBegin, colEnd), in
+    // parallel, and returns when all calls have finished. A block is split along the dimension with more grains, until it is
+    // smaller than rowGrainSize rows and colGrainSize columns.
+    void ParallelFor2D(int rowBegin, int rowEnd, int colBegin, int colEnd, int rowGrainSize, int colGrainSize, const Body2D& body);
+
+    // Runs a function asynchronously on one of the threads, and returns immediately. If the pool has no workers, the function runs
+    // on the calling thread before Submit returns. Functions that are still queued when the pool is destroyed run before the
+    // destructor returns. A thread waiting for a parallel loop can pick up a submitted function, which delays that loop.
+    void Submit(std::function<void()> function);
+
+private:
+    struct Loop;
+    // a task is either a block of a parallel loop or, if function is not null, a submitted function
+    struct Task
+    {
+        Loop* loop;
+        int rowBegin;
+        int rowEnd;
+        int colBegin;
+        int colEnd;
+        std::function<void()>* function;
+    };
+
+    struct TaskDeque
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void WorkerLoop(int index);
+    int GetCurrentDequeIndex() const;
+    void Push(int dequeIndex, const Task& task);
+    bool TryPop(int dequeIndex, Task& task);
+    bool TrySteal(int dequeIndex, Task& task);
+    bool TryRunTask(int dequeIndex);
+    void RunTask(int dequeIndex, Task task);
+
+    std::vector<std::thread> _workers;
+    std::vector<long> _workerThreadIds;
+    std::atomic<int> _startedWorkerCount;
+    AffinityPolicy _affinityPolicy = AffinityPolicy::none;
+    std::vector<int> _affinityCpus;
+
+    // deque 0 is shared by all threads outside the pool, deque i > 0 is owned by worker i
+    std::vector<std::unique_ptr<TaskDeque>> _deques;
+    std::atomic<int> _queuedTaskCount;
+    std::mutex _sleepMutex;
+    std::condition_variable _taskAdded;
+    bool _isStopping = false;
+};
+
+// minimum number of elements copied by each thread in a parallel copy loop, such as an input unroll
+const int minParallelCopySize = 1 << 15;
+
+// Calls body(first, last) on disjoint subranges of [begin, end) on the shared thread pool, or calls body(begin, end) directly
+// if the total work is smaller than minParallelWork elements
+// workPerElement: number of elements of work represented by each element of the range
+inline void ParallelFor(int begin, int end, int workPerElement, int minParallelWork, const std::function<void(int, int)>& body)
+{
+    long long work = (long long)(end - begin) * workPerElement;
+    if(work < minParallelWork)
+    {
+        body(begin, end);
+        return;
+    }
+
+    int grainSize = (int)((minParallelWork + workPerElement - 1) / workPerElement);
+    ThreadPool::GetShared().ParallelFor(begin, end, grainSize, body);
+}
+
+// Calls body(rowBegin, rowEnd, colBegin, colEnd) on disjoint blocks of [0, rows) x [0, cols) on the shared thread pool, or
+// calls body(0, rows, 0, cols) directly if the total work is smaller than minParallelWork elements. Blocks are split along
+// rows down to single rows before they are split along columns.
+// workPerElement: number of elements of work represented by each (row, column) element of the range
+inline void ParallelFor2D(int rows, int cols, int workPerElement, int minParallelWork, const ThreadPool::Body2D& body)
+{
+    long long work = (long long)rows * cols * workPerElement;
+    if(work < minParallelWork)
+    {
+        body(0, rows, 0, cols);
+        return;
+    }
+
+    long long rowWork = (long long)cols * workPerElement;
+    int rowGrainSize = (int)std::max(1LL, (minParallelWork + rowWork - 1) / rowWork);
+    int colGrainSize = rowGrainSize > 1 ? cols : (int)((minParallelWork + workPerElement - 1) / workPerElement);
+    ThreadPool::GetShared().ParallelFor2D(0, rows, 0, cols, rowGrainSize, colGrainSize, body);
+}
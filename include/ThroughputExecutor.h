@@ -0,0 +1,49 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ThroughputExecutor.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+// Gets the number of inputs that RunConcurrently processes at the same time, each with its own slice of the temporary space
+inline int GetConcurrentSliceCount(int inputCount)
+{
+    return std::min(inputCount, ThreadPool::GetShared().GetThreadCount());
+}
+
+// Runs a convolution on each of a batch of independent inputs, with the inputs processed concurrently on the shared thread pool
+// and BLAS restricted to a single thread. Many concurrent single-threaded convolutions usually have higher throughput than one
+// convolution at a time with multi-threaded BLAS, at the cost of higher latency per input. Any parallel loop inside the
+// convolution (such as a parallel unroll) shares the same pool, and its tasks are stolen by threads that run out of inputs.
+//
+// inputs: array of inputCount pointers to input tensors
+// outputs: array of inputCount pointers to output tensors
+// inputCount: number of inputs
+// space: pointer to temporary space of size at least (spaceSize * sliceCount), where sliceCount is given by GetConcurrentSliceCount
+// spaceSize: size of the temporary space required by one convolution
+// convolution: function that is called as convolution(X, Y, space) for each input X, its output Y and a slice of the temporary space
+template <typename InputType, typename OutputType, typename SpaceType, typename ConvolutionType>
+void RunConcurrently(const InputType* const* inputs, OutputType* const* outputs, int inputCount, SpaceType* space, int spaceSize, const ConvolutionType& convolution)
+{
+    int sliceCount = GetConcurrentSliceCount(inputCount);
+    SingleThreadedBlasScope blasScope;
+
+    // each slice of the temporary space processes the inputs slice, slice + sliceCount, slice + 2 * sliceCount, ...
+    ThreadPool::GetShared().ParallelFor(0, sliceCount, 1, [&](int sliceBegin, int sliceEnd)
+    {
+        for(int slice = sliceBegin; slice < sliceEnd; ++slice)
+        {
+            for(int input = slice; input < inputCount; input += sliceCount)
+            {
+                convolution(inputs[input], outputs[input], space + slice * spaceSize);
+            }
+        }
+    });
+}
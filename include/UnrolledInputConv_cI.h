@@ -10,10 +10,12 @@
 #include "BlasHelpers.h"
 #include "ConvProperties.h"
 #include "Tensor.h"
+#include "ThreadPool.h"
 
-// Helper function that unrolls a channel-major input tensor into an unrolled input matrix
-template <typename ElementType>
-void ChlMajInputUnroll(const ElementType* X, 
+// Helper function that fills the block [yRowBegin, yRowEnd) x [uColBegin, uColEnd) of the column-major unrolled input matrix, where
+// each column of U is divided into yRows runs of yCols elements, from a channel-major input tensor
+template <typename InputType, typename ElementType>
+void ChlMajInputUnrollBlock(const InputType* X, 
     ElementType* U,
     int wRows,
     int wCols,
@@ -22,40 +24,66 @@ void ChlMajInputUnroll(const ElementType* X,
     int yRows, 
     int yCols, 
     int uRows,
-    int uCols)
+    int uCols,
+    int uColBegin,
+    int uColEnd,
+    int yRowBegin,
+    int yRowEnd)
 {
     int copySize = yCols;
     int xRows = (yRows - 1) * vStride + wRows;
     int xCols = yCols + wCols - 1;
     int xChls = wChls;
 
-    for(int wRow = 0; wRow < wRows; ++wRow) {
-        for(int wCol = 0; wCol < wCols; ++wCol) {
-            for(int wChl = 0; wChl < wChls; ++wChl) {
-                for(int yRow = 0; yRow < yRows; ++yRow) {
+    for(int uCol = uColBegin; uCol < uColEnd; ++uCol) {
+
+        // each column of U corresponds to one (filter row, filter column, channel) position
+        int wRow = uCol / (wCols * wChls);
+        int wCol = (uCol / wChls) % wCols;
+        int wChl = uCol % wChls;
+
+        for(int yRow = yRowBegin; yRow < yRowEnd; ++yRow) {
 
-                    // calculate copy source
-                    int xRow = yRow * vStride + wRow;
-                    int xCol = wCol;
-                    int xChl = wChl;
-                    const float* source = X + (xChl * xRows + xRow) * xCols + xCol;
-                    
-                    // calculate copy target
-                    int uCol =  (wRow * wCols + wCol) * wChls + wChl;
-                    ElementType* target = U + (uCol * yRows + yRow) * yCols;
+            // calculate copy source
+            int xRow = yRow * vStride + wRow;
+            int xCol = wCol;
+            int xChl = wChl;
+            const InputType* source = X + (xChl * xRows + xRow) * xCols + xCol;
+            
+            // calculate copy target
+            ElementType* target = U + (uCol * yRows + yRow) * yCols;
 
-                    // copy from X to U
-                    assert(source >= X);
-                    assert(source + copySize <= X + xRows * xCols * xChls);
-                    assert(target >= U);
-                    assert(target + copySize <= U + uRows * uCols);
-                    std::copy(source, source + copySize, target);
-                }   
-            }  
+            // copy from X to U
+            assert(source >= X);
+            assert(source + copySize <= X + xRows * xCols * xChls);
+            assert(target >= U);
+            assert(target + copySize <= U + uRows * uCols);
+            std::copy(source, source + copySize, target);
         }   
     }   
 }
 
+// Helper function that unrolls a channel-major input tensor into an unrolled input matrix, converting the input elements to the unrolled element type
+// * multi-threaded, each task on the shared thread pool fills a block of columns of U (a block of filter positions and input
+//   channels) and output rows, so that the work is balanced even when U has fewer columns than there are threads
+template <typename InputType, typename ElementType>
+void ChlMajInputUnroll(const InputType* X, 
+    ElementType* U,
+    int wRows,
+    int wCols,
+    int wChls,
+    int vStride, 
+    int yRows, 
+    int yCols, 
+    int uRows,
+    int uCols)
+{
+    ParallelFor2D(uCols, yRows, yCols, minParallelCopySize, [&](int uColBegin, int uColEnd, int yRowBegin, int yRowEnd)
+    {
+        ChlMajInputUnrollBlock(X, U, wRows, wCols, wChls, vStride, yRows, yCols, uRows, uCols, uColBegin, uColEnd, yRowBegin, yRowEnd);
+    });
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // 2D Tensor Convolution
 // * supports only horizontal stride of 1
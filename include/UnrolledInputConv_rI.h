@@ -10,12 +10,14 @@
 #include "BlasHelpers.h"
 #include "ConvProperties.h"
 #include "Tensor.h"
+#include "ThreadPool.h"
 
 #include <cassert>
 
-// Helper function that unrolls a channel-major input tensor into an unrolled input matrix
-template <typename ElementType>
-void RowMajInputUnroll(const ElementType* X, 
+// Helper function that unrolls a row-major input tensor into an unrolled input matrix, converting the input elements to the unrolled element type
+// * generic version, with the filter shape and strides given at runtime
+template <typename InputType, typename ElementType>
+void RowMajInputUnrollGeneric(const InputType* X, 
     ElementType* U,
     int wRows, 
     int wCols, 
@@ -42,11 +44,11 @@ void RowMajInputUnroll(const ElementType* X,
                 // calculate copy source
                 int xRow = yRow * vStride + wRow;
                 int xCol = yCol * hStride;
-                const float* source = X + (xRow * xCols + xCol) * xChls;
+                const InputType* source = X + (xRow * xCols + xCol) * xChls;
 
                 // calculate copy target
                 int uRow = yRow * yCols + yCol;
-                float* target = U + (uRow * wRows + wRow) * copySize;
+                ElementType* target = U + (uRow * wRows + wRow) * copySize;
 
                 // copy from X to U
                 assert(source >= X);
@@ -59,6 +61,138 @@ void RowMajInputUnroll(const ElementType* X,
     }   
 }
 
+// Helper function that unrolls a row-major input tensor into an unrolled input matrix, converting the input elements to the unrolled element type
+// * specialized version, with the filter shape and strides given at compile time, so that the loop over filter rows is fully unrolled
+//   and the source and target offsets are compile-time multiples of the row sizes
+template <int wRows, int wCols, int vStride, int hStride, typename InputType, typename ElementType>
+void RowMajInputUnrollSpecialized(const InputType* X, 
+    ElementType* U,
+    int wChls, 
+    int yRows, 
+    int yCols,
+    int uRows,
+    int uCols)
+{
+    int xCols = (yCols - 1) * hStride + wCols;
+    int xChls = wChls;
+
+    int copySize = wCols * wChls;
+    int xRowSize = xCols * xChls;
+    assert(uRows == yRows * yCols && uCols == wRows * copySize);
+
+    for(int yRow = 0; yRow < yRows; ++yRow) 
+    {
+        const InputType* source = X + yRow * vStride * xRowSize;
+        ElementType* target = U + yRow * yCols * uCols;
+        for(int yCol = 0; yCol < yCols; ++yCol) 
+        {
+            for(int wRow = 0; wRow < wRows; ++wRow) 
+            {
+                std::copy(source + wRow * xRowSize, source + wRow * xRowSize + copySize, target + wRow * copySize);
+            }
+            source += hStride * xChls;
+            target += uCols;
+        }   
+    }   
+}
+
+// Helper function that dispatches to the specialization for square filters of the given size and strides of 1 or 2
+template <int wSize, typename InputType, typename ElementType>
+void RowMajInputUnrollSquare(const InputType* X, ElementType* U, int wChls, int vStride, int hStride, int yRows, int yCols, int uRows, int uCols)
+{
+    if(vStride == 1 && hStride == 1)
+    {
+        RowMajInputUnrollSpecialized<wSize, wSize, 1, 1>(X, U, wChls, yRows, yCols, uRows, uCols);
+    }
+    else if(vStride == 1 && hStride == 2)
+    {
+        RowMajInputUnrollSpecialized<wSize, wSize, 1, 2>(X, U, wChls, yRows, yCols, uRows, uCols);
+    }
+    else if(vStride == 2 && hStride == 1)
+    {
+        RowMajInputUnrollSpecialized<wSize, wSize, 2, 1>(X, U, wChls, yRows, yCols, uRows, uCols);
+    }
+    else
+    {
+        assert(vStride == 2 && hStride == 2);
+        RowMajInputUnrollSpecialized<wSize, wSize, 2, 2>(X, U, wChls, yRows, yCols, uRows, uCols);
+    }
+}
+
+// returns true if RowMajInputUnroll has a compile-time specialization for the given filter shape and strides (1x1, 3x3, 5x5 and 7x7 filters with strides 1 and 2)
+inline bool IsRowMajInputUnrollSpecialized(int wRows, int wCols, int vStride, int hStride)
+{
+    bool isSupportedSize = wRows == wCols && (wRows == 1 || wRows == 3 || wRows == 5 || wRows == 7);
+    bool isSupportedStride = (vStride == 1 || vStride == 2) && (hStride == 1 || hStride == 2);
+    return isSupportedSize && isSupportedStride;
+}
+
+// Helper function that unrolls a row-major input tensor into an unrolled input matrix, converting the input elements to the unrolled element type
+// * single-threaded, uses a compile-time specialization for common filter shapes and strides, and the generic version otherwise
+template <typename InputType, typename ElementType>
+void RowMajInputUnrollSerial(const InputType* X, 
+    ElementType* U,
+    int wRows, 
+    int wCols, 
+    int wChls, 
+    int vStride, 
+    int hStride, 
+    int yRows, 
+    int yCols,
+    int uRows,
+    int uCols)
+{
+    if(IsRowMajInputUnrollSpecialized(wRows, wCols, vStride, hStride))
+    {
+        switch(wRows)
+        {
+        case 1:
+            RowMajInputUnrollSquare<1>(X, U, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+            return;
+        case 3:
+            RowMajInputUnrollSquare<3>(X, U, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+            return;
+        case 5:
+            RowMajInputUnrollSquare<5>(X, U, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+            return;
+        case 7:
+            RowMajInputUnrollSquare<7>(X, U, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+            return;
+        }
+    }
+
+    RowMajInputUnrollGeneric(X, U, wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+}
+
+// Helper function that unrolls a row-major input tensor into an unrolled input matrix, converting the input elements to the unrolled element type
+// * multi-threaded, each thread on the shared thread pool unrolls a band of output rows with RowMajInputUnrollSerial
+template <typename InputType, typename ElementType>
+void RowMajInputUnroll(const InputType* X, 
+    ElementType* U,
+    int wRows, 
+    int wCols, 
+    int wChls, 
+    int vStride, 
+    int hStride, 
+    int yRows, 
+    int yCols,
+    int uRows,
+    int uCols)
+{
+    assert(uRows == yRows * yCols);
+    int xCols = (yCols - 1) * hStride + wCols;
+    int xChls = wChls;
+
+    ParallelFor(0, yRows, yCols * uCols, minParallelCopySize, [&](int yRowBegin, int yRowEnd)
+    {
+        // output rows [yRowBegin, yRowEnd) read input rows starting at yRowBegin * vStride and fill a contiguous block of U
+        const InputType* source = X + yRowBegin * vStride * xCols * xChls;
+        ElementType* target = U + yRowBegin * yCols * uCols;
+        int bandRows = yRowEnd - yRowBegin;
+        RowMajInputUnrollSerial(source, target, wRows, wCols, wChls, vStride, hStride, bandRows, yCols, bandRows * yCols, uCols);
+    });
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // 2D Tensor Convolution
 // * unrolled input 
@@ -10,6 +10,7 @@
 #include "BlasHelpers.h"
 #include "ConvProperties.h"
 #include "Tensor.h"
+#include "ThreadPool.h"
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // 2D Tensor Convolution
@@ -58,30 +59,30 @@ void Convolution(ConvProperties<ChannelMajorInput, ExplicitOutputPadding, Filter
     int uCols = wRows * wCols * wChls;
     ElementType* U = space;
 
-    // unroll the input
+    // unroll the input, with each thread on the shared thread pool filling a block of columns of U
     int copySize = uRows;
-    for(int wRow = 0; wRow < wRows; ++wRow) 
+    ParallelFor(0, uCols, copySize, minParallelCopySize, [&](int uColBegin, int uColEnd)
     {
-        for(int wCol = 0; wCol < wCols; ++wCol) 
+        for(int uCol = uColBegin; uCol < uColEnd; ++uCol) 
         {
-            for(int wChl = 0; wChl < wChls; ++wChl) 
-            {
-                // calculate copy source
-                const float* source = X + (wChl * xRows + wRow) * xCols + wCol;
+            int wRow = uCol / (wCols * wChls);
+            int wCol = (uCol / wChls) % wCols;
+            int wChl = uCol % wChls;
 
-                // calculate copy target
-                int uCol = (wRow * wCols + wCol) * wChls + wChl;
-                float* target = U + uCol * copySize;
+            // calculate copy source
+            const ElementType* source = X + (wChl * xRows + wRow) * xCols + wCol;
 
-                // copy from X to U
-                assert(source >= X);
-                assert(source + copySize <= X + xRows * xCols * xChls);
-                assert(target >= U);
-                assert(target + copySize <= U + uRows * uCols);
-                std::copy(source, source + copySize, target);
-            }  
-        }   
-    }
+            // calculate copy target
+            ElementType* target = U + uCol * copySize;
+
+            // copy from X to U
+            assert(source >= X);
+            assert(source + copySize <= X + xRows * xCols * xChls);
+            assert(target >= U);
+            assert(target + copySize <= U + uRows * uCols);
+            std::copy(source, source + copySize, target);
+        }
+    });
 
     // reshape the filter-major filter tensor W to a column-major matrix V
     int vCols = wCount;
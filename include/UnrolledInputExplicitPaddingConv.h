@@ -98,11 +98,11 @@ void Convolution(ConvProperties<ChannelMajorInput, ExplicitInputPadding, Explici
             for(int wChl = 0; wChl < wChls; ++wChl) 
             {
                 // calculate copy source
-                const float* source = X + (wChl * xRows + wRow) * xCols + wCol;
+                const ElementType* source = X + (wChl * xRows + wRow) * xCols + wCol;
 
                 // calculate copy target
                 int uCol = (wRow * wCols + wCol) * wChls + wChl;
-                float* target = U + uCol * copySize;
+                ElementType* target = U + uCol * copySize;
 
                 // copy from X to U
                 assert(source + distToContent >= X);
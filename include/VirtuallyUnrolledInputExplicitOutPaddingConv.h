@@ -11,6 +11,8 @@
 #include "ConvProperties.h"
 #include "Tensor.h"
 
+#include <vector>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // 2D Tensor Convolution
 // * supports only odd number of filter rows and columns
@@ -53,12 +55,23 @@ void Convolution(ConvProperties<ExplicitOutputPadding, OddField, RowMajorFilters
     // reshape the relevant part of the output tensor Y into a row-major matrix Z
     ElementType* Z = Y + (yPadLeft + xCols * yPadTop) * yChls;
 
+    // the multiplications of all the filter positions are collected and performed as a single batch of small GEMMs
+    int batchCapacity = wRows * wCols;
+    std::vector<int> batchRows;
+    std::vector<const ElementType*> batchP, batchV;
+    std::vector<ElementType> batchBeta;
+    std::vector<ElementType*> batchZ;
+    batchRows.reserve(batchCapacity);
+    batchP.reserve(batchCapacity);
+    batchV.reserve(batchCapacity);
+    batchBeta.reserve(batchCapacity);
+    batchZ.reserve(batchCapacity);
+
     // define a helper function that handles a single spatial filter position (row, col)
     auto ProcessFilterPosition = [&](int wRow, int wCol, ElementType beta)
     {
         // reshape the relevant part of the input tensor X into a row-major matrix P
         int pRows = yRows * yCols + (yRows - 1) * (wCols - 1);
-        int pCols = wChls;
         const ElementType* P = X + (wRow * xCols + wCol) * xChls;
 
         // reshape the relevant part of the filter tensor W into a row-major matrix V
@@ -67,8 +80,12 @@ void Convolution(ConvProperties<ExplicitOutputPadding, OddField, RowMajorFilters
        int vSize =  vRows * vCols;
        const ElementType* V = W + (wRow * wCols + wCol) * vSize;
 
-        // perform the matrix-matrix multiplication
-        Gemm(RowMaj, RowMaj, RowMaj, pRows, vCols, pCols, 1, P, V, beta, Z);
+        // add the matrix-matrix multiplication to the batch
+        batchRows.push_back(pRows);
+        batchP.push_back(P);
+        batchV.push_back(V);
+        batchBeta.push_back(beta);
+        batchZ.push_back(Z);
     };
 
     // process the TOP LEFT filter position across all channels
@@ -89,6 +106,9 @@ void Convolution(ConvProperties<ExplicitOutputPadding, OddField, RowMajorFilters
         }   
     }   
 
+    // perform the batch of matrix-matrix multiplications
+    GemmBatch((int)batchRows.size(), batchRows.data(), wCount, wChls, batchP.data(), batchV.data(), batchBeta.data(), batchZ.data());
+
     // delete the values that were written into the output padding
     int deleteSize = 2 * yPadLeft * yChls;
     for(int yRow = 0; yRow < yRows - 1; ++yRow)
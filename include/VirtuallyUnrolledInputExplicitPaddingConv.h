@@ -11,6 +11,8 @@
 #include "ConvProperties.h"
 #include "Tensor.h"
 
+#include <vector>
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 // 2D Tensor Convolution
 // * supports only odd number of filter rows and columns
@@ -57,6 +59,18 @@ void Convolution(ConvProperties<RowMajorInput, ExplicitInputPadding, ExplicitOut
     int xPadBottom = xPadTop;
     int xPadRight = xPadLeft;
 
+    // the multiplications of all the filter positions are collected and performed as a single batch of small GEMMs
+    int batchCapacity = wRows * wCols;
+    std::vector<int> batchRows;
+    std::vector<const ElementType*> batchP, batchV;
+    std::vector<ElementType> batchBeta;
+    std::vector<ElementType*> batchZ;
+    batchRows.reserve(batchCapacity);
+    batchP.reserve(batchCapacity);
+    batchV.reserve(batchCapacity);
+    batchBeta.reserve(batchCapacity);
+    batchZ.reserve(batchCapacity);
+
     // define a helper function that handles a single spatial filter position (row, col)
     auto ProcessFilterPosition = [&](int wRow, int wCol)
     {
@@ -87,7 +101,6 @@ void Convolution(ConvProperties<RowMajorInput, ExplicitInputPadding, ExplicitOut
 
         // reshape the relevant part of the input tensor X into the row-major matrix P
         int pRows = yRows * yCols + (yRows - 1) * (wCols - 1) - (distToContent + distFromContent);
-        int pCols = wChls;
         const ElementType* P = X + (wRow * xCols + wCol + distToContent) * xChls;
 
         // reshape the relevant part of the filter tensor W into the row-major matrix V
@@ -98,8 +111,12 @@ void Convolution(ConvProperties<RowMajorInput, ExplicitInputPadding, ExplicitOut
         // reshape the relevant part of the output tensor Y into a row-major matrix Z
         ElementType* Z = Y + (xCols * yPadTop + yPadLeft) * wCount + distToContent * vCols;
         
-        // perform matrix multiplication
-        Gemm(RowMaj, RowMaj, RowMaj, pRows, vCols, pCols, 1, P, V, 1, Z);
+        // add the matrix-matrix multiplication to the batch
+        batchRows.push_back(pRows);
+        batchP.push_back(P);
+        batchV.push_back(V);
+        batchBeta.push_back(1);
+        batchZ.push_back(Z);
     };
 
     // reset the output 
@@ -124,6 +141,9 @@ void Convolution(ConvProperties<RowMajorInput, ExplicitInputPadding, ExplicitOut
         }   
     }   
 
+    // perform the batch of matrix-matrix multiplications
+    GemmBatch((int)batchRows.size(), batchRows.data(), wCount, wChls, batchP.data(), batchV.data(), batchBeta.data(), batchZ.data());
+
     // delete the values that were written into the output padding
     int deleteSize = (wCols - 1) * wCount;
     for(int yRow = 0; yRow < yRows - 1; ++yRow)
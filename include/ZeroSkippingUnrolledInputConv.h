@@ -0,0 +1,157 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ZeroSkippingUnrolledInputConv.h
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "BlasHelpers.h"
+#include "ConvProperties.h"
+#include "Tensor.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+// minimum number of unrolled input rows (output pixels) in each band of the zero-skipping convolution, which keeps its matrix
+// multiplications large enough for BLAS to run efficiently
+const int zeroSkippingMinBandSize = 256;
+
+// Gets the number of output rows in each band of the zero-skipping convolution
+inline int GetZeroSkippingBandRows(int yRows, int yCols)
+{
+    return std::min(yRows, (zeroSkippingMinBandSize + yCols - 1) / yCols);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+// 2D Tensor Convolution
+// * supports only horizontal stride of 1
+// * unrolled input, one band of output rows at a time (see GetZeroSkippingBandRows), skipping the input channel-rows that are
+//   entirely zero under the band (e.g., dead channels after a ReLU, or the zero-padding at the top and bottom) - each skipped
+//   channel-row removes one column from the unrolled input of the band and one row from its filter matrix
+// * the filter rows are gathered only when the set of skipped channel-rows changes from one band to the next, and the filters
+//   are used in place when nothing is skipped
+// * filters in row-major order
+// * input tensor in channel-major order
+// * output tensor in row-major order
+// * requires temporary space of size (wRows * wCols * wChls * yRows * yCols + wRows * wCols * wChls * wCount)
+//
+// W: 4-dimensional weights tensor in row-major order
+// X: 3-dimensional input tensor in channel-major order
+// Y: 3-dimensional output tensor in row-major order
+// wCount: number of filters in W
+// wRows: number of rows in each filter in W
+// wCols: number of columns in each filter in W
+// wChls: number of channels in each filter in W
+// vStride: vertical stride
+// yRows: number of rows in the output tensor Y
+// yCols: number of columns in the output tensor Y
+// space: pointer to temporary space of size at least (wRows * wCols * wChls * yRows * yCols + wRows * wCols * wChls * wCount)
+// skippedFraction: if not null, receives the fraction of unrolled input elements that were skipped
+template <typename ElementType>
+void Convolution(ConvProperties<ChannelMajorInput, RowMajorFilters, RowMajorOutput, UnitHorizontalStride, UnrolledInput, ZeroSkippingInput>,
+    const ElementType* W, 
+    const ElementType* X, 
+    ElementType* Y, 
+    int wCount, 
+    int wRows, 
+    int wCols, 
+    int wChls, 
+    int vStride, 
+    int yRows, 
+    int yCols,
+    ElementType* space,
+    double* skippedFraction = nullptr)
+{
+    int xRows = (yRows - 1) * vStride + wRows;
+    int xCols = yCols + wCols - 1;
+
+    // use temp space to store the unrolled input matrix U of one band in column-major order, followed by the matching rows of the
+    // filter matrix V in row-major order
+    int bandRows = GetZeroSkippingBandRows(yRows, yCols);
+    int uCols = wRows * wCols * wChls;
+    ElementType* U = space;
+    ElementType* gathered = space + bandRows * yCols * uCols;
+
+    // the unrolled input columns kept in the current and previous bands
+    std::vector<int> kept;
+    std::vector<int> gatheredKept;
+    kept.reserve(uCols);
+
+    long long skippedCount = 0;
+    for(int yRow = 0; yRow < yRows; yRow += bandRows)
+    {
+        int rows = std::min(bandRows, yRows - yRow);
+        int uRows = rows * yCols;
+
+        // unroll the channel-rows that are nonzero somewhere under the band
+        kept.clear();
+        for(int wRow = 0; wRow < wRows; ++wRow) 
+        {
+            for(int wCol = 0; wCol < wCols; ++wCol) 
+            {
+                for(int wChl = 0; wChl < wChls; ++wChl) 
+                {
+                    // the channel-row of each output row of the band is contiguous, and consecutive output rows are vStride
+                    // input rows apart
+                    const ElementType* source = X + (wChl * xRows + yRow * vStride + wRow) * xCols + wCol;
+                    bool isZero = true;
+                    for(int row = 0; row < rows && isZero; ++row)
+                    {
+                        const ElementType* rowSource = source + row * vStride * xCols;
+                        isZero = std::all_of(rowSource, rowSource + yCols, [](ElementType x) { return x == 0; });
+                    }
+                    if(isZero)
+                    {
+                        skippedCount += uRows;
+                        continue;
+                    }
+
+                    // copy from X to the next column of U
+                    ElementType* target = U + kept.size() * uRows;
+                    for(int row = 0; row < rows; ++row)
+                    {
+                        const ElementType* rowSource = source + row * vStride * xCols;
+                        assert(rowSource + yCols <= X + xRows * xCols * wChls);
+                        std::copy(rowSource, rowSource + yCols, target + row * yCols);
+                    }
+                    kept.push_back((wRow * wCols + wCol) * wChls + wChl);
+                }
+            }
+        }
+        int kCount = (int)kept.size();
+
+        // the output band is a row-major matrix Z
+        ElementType* Z = Y + yRow * yCols * wCount;
+        if(kCount == 0)
+        {
+            std::fill(Z, Z + uRows * wCount, ElementType(0));
+            continue;
+        }
+
+        // reshape the filters tensor W into a row-major matrix V, gathering its kept rows if some were skipped
+        const ElementType* V = W;
+        if(kCount < uCols)
+        {
+            if(kept != gatheredKept)
+            {
+                for(int k = 0; k < kCount; ++k)
+                {
+                    std::copy(W + kept[k] * wCount, W + (kept[k] + 1) * wCount, gathered + k * wCount);
+                }
+                gatheredKept = kept;
+            }
+            V = gathered;
+        }
+
+        // matrix-matrix multiply, over the nonzero columns of U only
+        Gemm(ColMaj, RowMaj, RowMaj, uRows, wCount, kCount, 1, U, V, 0, Z);
+    }
+
+    if(skippedFraction != nullptr)
+    {
+        *skippedFraction = (double)skippedCount / ((double)yRows * yCols * uCols);
+    }
+}
@@ -0,0 +1,58 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     BackgroundIoThread.cpp
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "BackgroundIoThread.h"
+
+// stl
+#include <utility>
+
+BackgroundIoThread::BackgroundIoThread() : _thread(&BackgroundIoThread::Loop, this)
+{}
+
+BackgroundIoThread::~BackgroundIoThread()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+    }
+    _jobAdded.notify_one();
+    _thread.join();
+}
+
+std::future<void> BackgroundIoThread::Submit(std::function<void()> job)
+{
+    std::packaged_task<void()> task(std::move(job));
+    auto future = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(std::move(task));
+    }
+    _jobAdded.notify_one();
+    return future;
+}
+
+void BackgroundIoThread::Loop()
+{
+    while(true)
+    {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobAdded.wait(lock, [this]() { return _isStopping || !_jobs.empty(); });
+            if(_jobs.empty())
+            {
+                return;
+            }
+            task = std::move(_jobs.front());
+            _jobs.pop_front();
+        }
+
+        // the packaged task stores any exception in its future
+        task();
+    }
+}
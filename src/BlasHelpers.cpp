@@ -9,11 +9,17 @@
 #include "BlasHelpers.h"
 
 // stl
+#include <algorithm>
 #include <iostream>
+#include <mutex>
 
 #ifdef USE_BLAS
 #include BLAS_HEADER_FILE
 
+#ifdef BLAS_MKL_THREADING
+#include <mkl_service.h>
+#endif
+
 void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int n, int k, float alpha, const float* A, int lda, const float* B, int ldb, float beta, float* C, int ldc)
 {
     CBLAS_ORDER blasOrder = (matrixOrderC == RowMaj) ? CBLAS_ORDER::CblasRowMajor : CBLAS_ORDER::CblasColMajor;
@@ -23,32 +29,89 @@ void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int
     cblas_sgemm(blasOrder, blasTransposeA, blasTransposeB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
 }
 
+void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int n, int k, double alpha, const double* A, int lda, const double* B, int ldb, double beta, double* C, int ldc)
+{
+    CBLAS_ORDER blasOrder = (matrixOrderC == RowMaj) ? CBLAS_ORDER::CblasRowMajor : CBLAS_ORDER::CblasColMajor;
+    CBLAS_TRANSPOSE blasTransposeA = transposeA ? CBLAS_TRANSPOSE::CblasTrans : CBLAS_TRANSPOSE::CblasNoTrans;
+    CBLAS_TRANSPOSE blasTransposeB = transposeB ? CBLAS_TRANSPOSE::CblasTrans : CBLAS_TRANSPOSE::CblasNoTrans;
+
+    cblas_dgemm(blasOrder, blasTransposeA, blasTransposeB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
 void Axpy(int n, float alpha, const float* X, int incX, float* Y, int incY)
 {
     cblas_saxpy(n, alpha, X, incX, Y, incY);
 }
 
+void Axpy(int n, double alpha, const double* X, int incX, double* Y, int incY)
+{
+    cblas_daxpy(n, alpha, X, incX, Y, incY);
+}
+
 void Copy(int n, const float* X, int incX, float* Y, int incY)
 {
     cblas_scopy(n, X, incX, Y, incY);
 }
 
+void Copy(int n, const double* X, int incX, double* Y, int incY)
+{
+    cblas_dcopy(n, X, incX, Y, incY);
+}
+
+#if defined(BLAS_MKL_THREADING)
+
+int GetBlasThreadCount()
+{
+    return mkl_get_max_threads();
+}
+
+void SetBlasThreadCount(int threadCount)
+{
+    mkl_set_num_threads(threadCount);
+}
+
+#elif defined(BLAS_OPENBLAS_THREADING)
+
+int GetBlasThreadCount()
+{
+    return openblas_get_num_threads();
+}
+
+void SetBlasThreadCount(int threadCount)
+{
+    openblas_set_num_threads(threadCount);
+}
+
 #else
 
-void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int n, int k, float alpha, const float* A, int lda, const float* B, int ldb, float beta, float* C, int ldc)
+// the thread count of this BLAS configuration cannot be controlled
+int GetBlasThreadCount()
+{
+    return 1;
+}
+
+void SetBlasThreadCount(int)
+{}
+
+#endif
+
+#else
+
+template <typename ElementType>
+void ReferenceGemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int n, int k, ElementType alpha, const ElementType* A, int lda, const ElementType* B, int ldb, ElementType beta, ElementType* C, int ldc)
 {
     MatrixOrder matrixOrderA = (matrixOrderC == RowMaj) ^ transposeA ? RowMaj : ColMaj;
     MatrixOrder matrixOrderB = (matrixOrderC == RowMaj) ^ transposeB ? RowMaj : ColMaj;
 
-    auto AMat = MatrixConstInterface<float>(A, { m, k }, matrixOrderA); 
-    auto BMat = MatrixConstInterface<float>(B, { k, n }, matrixOrderB);
-    auto CMat = MatrixInterface<float>(C, { m, n }, matrixOrderC);
+    auto AMat = MatrixConstInterface<ElementType>(A, { m, k }, matrixOrderA); 
+    auto BMat = MatrixConstInterface<ElementType>(B, { k, n }, matrixOrderB);
+    auto CMat = MatrixInterface<ElementType>(C, { m, n }, matrixOrderC);
     
     for (int i = 0; i < CMat.Size(0); ++i)
     {
         for (int j = 0; j < CMat.Size(1); ++j)
         {
-            float value = 0;
+            ElementType value = 0;
             for (int k = 0; k < AMat.Size(1); ++k)
             {
                 value += AMat({i, k}) * BMat({k, j});
@@ -58,7 +121,18 @@ void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int
     }
 }
 
-void Axpy(int n, float alpha, const float* X, int incX, float* Y, int incY)
+void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int n, int k, float alpha, const float* A, int lda, const float* B, int ldb, float beta, float* C, int ldc)
+{
+    ReferenceGemm(matrixOrderC, transposeA, transposeB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+void Gemm(MatrixOrder matrixOrderC, bool transposeA, bool transposeB, int m, int n, int k, double alpha, const double* A, int lda, const double* B, int ldb, double beta, double* C, int ldc)
+{
+    ReferenceGemm(matrixOrderC, transposeA, transposeB, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+template <typename ElementType>
+void ReferenceAxpy(int n, ElementType alpha, const ElementType* X, int incX, ElementType* Y, int incY)
 {
     for(int i=0; i < n; ++i)
     {
@@ -66,7 +140,18 @@ void Axpy(int n, float alpha, const float* X, int incX, float* Y, int incY)
     }
 }
 
-void Copy(int n, const float* X, int incX, float* Y, int incY)
+void Axpy(int n, float alpha, const float* X, int incX, float* Y, int incY)
+{
+    ReferenceAxpy(n, alpha, X, incX, Y, incY);
+}
+
+void Axpy(int n, double alpha, const double* X, int incX, double* Y, int incY)
+{
+    ReferenceAxpy(n, alpha, X, incX, Y, incY);
+}
+
+template <typename ElementType>
+void ReferenceCopy(int n, const ElementType* X, int incX, ElementType* Y, int incY)
 {
     for(int i=0; i < n; ++i)
     {
@@ -74,6 +159,25 @@ void Copy(int n, const float* X, int incX, float* Y, int incY)
     }    
 }
 
+void Copy(int n, const float* X, int incX, float* Y, int incY)
+{
+    ReferenceCopy(n, X, incX, Y, incY);
+}
+
+void Copy(int n, const double* X, int incX, double* Y, int incY)
+{
+    ReferenceCopy(n, X, incX, Y, incY);
+}
+
+// the reference implementation is single-threaded
+int GetBlasThreadCount()
+{
+    return 1;
+}
+
+void SetBlasThreadCount(int)
+{}
+
 void PrintBlasInfo()
 {
     std::cout << "BLAS not used\n";
@@ -81,14 +185,53 @@ void PrintBlasInfo()
 
 #endif
 
+//
+// SingleThreadedBlasScope
+//
+
+static std::mutex singleThreadedBlasMutex;
+static int singleThreadedBlasScopeCount = 0;
+static int savedBlasThreadCount = 1;
+
+SingleThreadedBlasScope::SingleThreadedBlasScope()
+{
+    std::lock_guard<std::mutex> lock(singleThreadedBlasMutex);
+    if(singleThreadedBlasScopeCount++ == 0)
+    {
+        savedBlasThreadCount = GetBlasThreadCount();
+        SetBlasThreadCount(1);
+    }
+}
+
+SingleThreadedBlasScope::~SingleThreadedBlasScope()
+{
+    std::lock_guard<std::mutex> lock(singleThreadedBlasMutex);
+    if(--singleThreadedBlasScopeCount == 0)
+    {
+        SetBlasThreadCount(savedBlasThreadCount);
+    }
+}
+
 // Gemm with three order parameters instead of one order parameter and two transpose parameters
-void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, float alpha, const float* A, int lda, const float* B, int ldb, float beta, float* C, int ldc)
+template <typename ElementType>
+void GemmO(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, ElementType alpha, const ElementType* A, int lda, const ElementType* B, int ldb, ElementType beta, ElementType* C, int ldc)
 {
     Gemm(matrixOrderC, (matrixOrderA != matrixOrderC), (matrixOrderB != matrixOrderC), m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
 }
 
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, float alpha, const float* A, int lda, const float* B, int ldb, float beta, float* C, int ldc)
+{
+    GemmO(matrixOrderA, matrixOrderB, matrixOrderC, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, double alpha, const double* A, int lda, const double* B, int ldb, double beta, double* C, int ldc)
+{
+    GemmO(matrixOrderA, matrixOrderB, matrixOrderC, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+}
+
 // Gemm that automatically sets lda, ldb, ldc to their default values
-void GemmS(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, float alpha, const float* A, const float* B, float beta, float* C)
+template <typename ElementType>
+void GemmS(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, ElementType alpha, const ElementType* A, const ElementType* B, ElementType beta, ElementType* C)
 {
     int lda = (matrixOrderA == RowMaj) ? k : m;
     int ldb = (matrixOrderB == RowMaj) ? n : k;
@@ -97,7 +240,8 @@ void GemmS(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matri
 }
 
 // Equivalent formulation of Gemm that uses the transposes of all matrices (Transp(C) = Transp(B) * Transp(A))
-void GemmT(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, float alpha, const float* A, const float* B, float beta, float* C)
+template <typename ElementType>
+void GemmT(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, ElementType alpha, const ElementType* A, const ElementType* B, ElementType beta, ElementType* C)
 {
     GemmS(Transpose(matrixOrderB), Transpose(matrixOrderA), Transpose(matrixOrderC), n, m, k, alpha, B, A, beta, C);
 }
@@ -108,3 +252,236 @@ void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrix
     //GemmS(matrixOrderA, matrixOrderB, matrixOrderC, m, n, k, alpha, A, B, beta, C);
     GemmT(matrixOrderA, matrixOrderB, matrixOrderC, m, n, k, alpha, A, B, beta, C);
 }
+
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, double alpha, const double* A, const double* B, double beta, double* C)
+{
+    GemmT(matrixOrderA, matrixOrderB, matrixOrderC, m, n, k, alpha, A, B, beta, C);
+}
+//
+// Batched GEMM
+//
+
+// below this number of multiply-adds, the batched GEMM uses its own microkernel instead of a separate BLAS call per multiplication.
+// BLAS wins above roughly a thousand multiply-adds (the microkernel is only faster where the call overhead of BLAS dominates),
+// and without BLAS the microkernel is always used.
+const int smallGemmThreshold = 16 * 16 * 4;
+
+// row-major microkernel for small matrices, which vectorizes the innermost loop over the columns of B and C
+template <typename ElementType>
+void SmallGemm(int m, int n, int k, const ElementType* A, const ElementType* B, ElementType beta, ElementType* C)
+{
+    for (int i = 0; i < m; ++i)
+    {
+        ElementType* c = C + i * n;
+        if(beta == 0)
+        {
+            std::fill(c, c + n, ElementType(0));
+        }
+        else if(beta != 1)
+        {
+            std::for_each(c, c + n, [beta](ElementType& value) { value *= beta; });
+        }
+
+        const ElementType* a = A + i * k;
+        for (int l = 0; l < k; ++l)
+        {
+            ElementType value = a[l];
+            const ElementType* b = B + l * n;
+            for (int j = 0; j < n; ++j)
+            {
+                c[j] += value * b[j];
+            }
+        }
+    }
+}
+
+// Batched GEMM, implemented as a sequence of multiplications because several of them may accumulate into the same output (which
+// rules out BLAS batch interfaces such as cblas_sgemm_batch, whose multiplications may run concurrently)
+template <typename ElementType>
+void GemmBatchT(int batchSize, const int* m, int n, int k, const ElementType* const* A, const ElementType* const* B, const ElementType* beta, ElementType* const* C)
+{
+    for(int i = 0; i < batchSize; ++i)
+    {
+#ifdef USE_BLAS
+        if((long long)m[i] * n * k > smallGemmThreshold)
+        {
+            Gemm(RowMaj, RowMaj, RowMaj, m[i], n, k, 1, A[i], B[i], beta[i], C[i]);
+            continue;
+        }
+#endif
+        SmallGemm(m[i], n, k, A[i], B[i], beta[i], C[i]);
+    }
+}
+
+void GemmBatch(int batchSize, const int* m, int n, int k, const float* const* A, const float* const* B, const float* beta, float* const* C)
+{
+    GemmBatchT(batchSize, m, n, k, A, B, beta, C);
+}
+
+void GemmBatch(int batchSize, const int* m, int n, int k, const double* const* A, const double* const* B, const double* beta, double* const* C)
+{
+    GemmBatchT(batchSize, m, n, k, A, B, beta, C);
+}
+
+//
+// Integer GEMM
+//
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+// sums the eight 32-bit integers in an AVX2 register
+static int32_t HorizontalSum(__m256i vector)
+{
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(vector), _mm256_extracti128_si256(vector, 1));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+#endif
+
+// dot product of an unsigned 8-bit vector and a signed 8-bit vector, with 32-bit accumulation
+static int32_t DotProduct(const uint8_t* a, const int8_t* b, int size)
+{
+    int i = 0;
+    int32_t result = 0;
+
+#if (defined(__AVX512VNNI__) && defined(__AVX512VL__)) || defined(__AVXVNNI__)
+    // VNNI multiplies groups of four unsigned/signed byte pairs and adds them directly to 32-bit accumulators
+    __m256i sum = _mm256_setzero_si256();
+    for(; i + 32 <= size; i += 32)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+        sum = _mm256_dpbusd_epi32(sum, va, vb);
+#else
+        sum = _mm256_dpbusd_avx_epi32(sum, va, vb);
+#endif
+    }
+    result = HorizontalSum(sum);
+#elif defined(__AVX2__)
+    // widen to 16 bits before multiplying, since maddubs saturates sums of two products such as 255 * 127 + 255 * 127
+    __m256i sum = _mm256_setzero_si256();
+    for(; i + 16 <= size; i += 16)
+    {
+        __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(a + i)));
+        __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(b + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(va, vb));
+    }
+    result = HorizontalSum(sum);
+#endif
+
+    // portable loop, also handles the remainder of the vectorized loops
+    for(; i < size; ++i)
+    {
+        result += (int32_t)a[i] * (int32_t)b[i];
+    }
+    return result;
+}
+
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, const uint8_t* A, const int8_t* B, int32_t* C)
+{
+    auto CMat = MatrixInterface<int32_t>(C, { m, n }, matrixOrderC);
+
+    // when the rows of A and the columns of B are contiguous, each element of C is a contiguous dot product
+    if(matrixOrderA == RowMaj && matrixOrderB == ColMaj)
+    {
+        for (int i = 0; i < m; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                CMat({i, j}) = DotProduct(A + i * k, B + j * k, k);
+            }
+        }
+        return;
+    }
+
+    auto AMat = MatrixConstInterface<uint8_t>(A, { m, k }, matrixOrderA); 
+    auto BMat = MatrixConstInterface<int8_t>(B, { k, n }, matrixOrderB);
+
+    for (int i = 0; i < m; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            int32_t value = 0;
+            for (int l = 0; l < k; ++l)
+            {
+                value += (int32_t)AMat({i, l}) * (int32_t)BMat({l, j});
+            }
+            CMat({i, j}) = value;
+        }
+    }
+}
+
+//
+// Binary GEMM
+//
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// counts the set bits in a 64-bit word
+static int32_t PopCount(uint64_t word)
+{
+#if defined(_MSC_VER)
+    return (int32_t)__popcnt64(word);
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+// counts the positions where two bit-packed vectors of -1/+1 values differ
+static int32_t MismatchCount(const uint64_t* a, const uint64_t* b, int size)
+{
+    // four independent counts, so that consecutive popcount instructions do not wait on each other
+    int32_t count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+    int i = 0;
+    for(; i + 4 <= size; i += 4)
+    {
+        count0 += PopCount(a[i] ^ b[i]);
+        count1 += PopCount(a[i + 1] ^ b[i + 1]);
+        count2 += PopCount(a[i + 2] ^ b[i + 2]);
+        count3 += PopCount(a[i + 3] ^ b[i + 3]);
+    }
+    for(; i < size; ++i)
+    {
+        count0 += PopCount(a[i] ^ b[i]);
+    }
+    return count0 + count1 + count2 + count3;
+}
+
+void Gemm(MatrixOrder matrixOrderA, MatrixOrder matrixOrderB, MatrixOrder matrixOrderC, int m, int n, int k, int kBits, const uint64_t* A, const uint64_t* B, int32_t* C)
+{
+    auto CMat = MatrixInterface<int32_t>(C, { m, n }, matrixOrderC);
+
+    // the dot product of two -1/+1 vectors is the number of matching positions (XNOR) minus the number of mismatching positions (XOR)
+    if(matrixOrderA == RowMaj && matrixOrderB == ColMaj)
+    {
+        for (int i = 0; i < m; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                CMat({i, j}) = kBits - 2 * MismatchCount(A + i * k, B + j * k, k);
+            }
+        }
+        return;
+    }
+
+    auto AMat = MatrixConstInterface<uint64_t>(A, { m, k }, matrixOrderA); 
+    auto BMat = MatrixConstInterface<uint64_t>(B, { k, n }, matrixOrderB);
+
+    for (int i = 0; i < m; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            int32_t mismatches = 0;
+            for (int l = 0; l < k; ++l)
+            {
+                mismatches += PopCount(AMat({i, l}) ^ BMat({l, j}));
+            }
+            CMat({i, j}) = kBits - 2 * mismatches;
+        }
+    }
+}
@@ -0,0 +1,279 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     JitRowMajInputUnroll.cpp
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "JitRowMajInputUnroll.h"
+
+// stl
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#ifdef JIT_AVAILABLE
+#include <sys/mman.h>
+#endif
+
+//
+// X64Emitter
+//
+
+void X64Emitter::MovImmediate(Register target, int32_t value)
+{
+    if(target >= 8)
+    {
+        EmitByte(0x41);
+    }
+    EmitByte(0xB8 + (target & 7));
+    EmitInt32(value);
+}
+
+void X64Emitter::Copy(Register source, int32_t sourceOffset, Register target, int32_t targetOffset, int size)
+{
+    // load and store opcodes for each size, where 16 bytes are copied through xmm0 (movups) and smaller sizes through rax
+    switch(size)
+    {
+    case 16:
+        EmitRex(false, rax, source);
+        EmitByte(0x0F);
+        EmitByte(0x10);
+        EmitMemoryOperand(0, source, sourceOffset);
+        EmitRex(false, rax, target);
+        EmitByte(0x0F);
+        EmitByte(0x11);
+        EmitMemoryOperand(0, target, targetOffset);
+        break;
+    case 8:
+        EmitRex(true, rax, source);
+        EmitByte(0x8B);
+        EmitMemoryOperand(rax, source, sourceOffset);
+        EmitRex(true, rax, target);
+        EmitByte(0x89);
+        EmitMemoryOperand(rax, target, targetOffset);
+        break;
+    case 4:
+    case 2:
+        if(size == 2)
+        {
+            EmitByte(0x66);
+        }
+        EmitRex(false, rax, source);
+        EmitByte(0x8B);
+        EmitMemoryOperand(rax, source, sourceOffset);
+        if(size == 2)
+        {
+            EmitByte(0x66);
+        }
+        EmitRex(false, rax, target);
+        EmitByte(0x89);
+        EmitMemoryOperand(rax, target, targetOffset);
+        break;
+    case 1:
+        EmitRex(false, rax, source);
+        EmitByte(0x8A);
+        EmitMemoryOperand(rax, source, sourceOffset);
+        EmitRex(false, rax, target);
+        EmitByte(0x88);
+        EmitMemoryOperand(rax, target, targetOffset);
+        break;
+    default:
+        assert(false && "unsupported copy size");
+    }
+}
+
+void X64Emitter::AddImmediate(Register target, int32_t value)
+{
+    EmitRex(true, rax, target);
+    EmitByte(0x81);
+    EmitByte(0xC0 | (target & 7));
+    EmitInt32(value);
+}
+
+void X64Emitter::Decrement(Register target)
+{
+    EmitRex(false, rax, target);
+    EmitByte(0xFF);
+    EmitByte(0xC8 | (target & 7));
+}
+
+void X64Emitter::JumpIfNotZero(size_t position)
+{
+    // the displacement is relative to the end of the 6-byte instruction
+    EmitByte(0x0F);
+    EmitByte(0x85);
+    EmitInt32((int32_t)((int64_t)position - (int64_t)(Position() + 4)));
+}
+
+void X64Emitter::Return()
+{
+    EmitByte(0xC3);
+}
+
+void X64Emitter::EmitInt32(int32_t value)
+{
+    auto bits = (uint32_t)value;
+    for(int i = 0; i < 4; ++i)
+    {
+        EmitByte((uint8_t)(bits >> (8 * i)));
+    }
+}
+
+void X64Emitter::EmitRex(bool isWide, Register reg, Register rm)
+{
+    // the REX prefix is needed for 64-bit operands and for the registers r8-r15
+    uint8_t rex = 0x40 | (isWide ? 0x08 : 0) | ((reg & 8) ? 0x04 : 0) | ((rm & 8) ? 0x01 : 0);
+    if(rex != 0x40)
+    {
+        EmitByte(rex);
+    }
+}
+
+void X64Emitter::EmitMemoryOperand(int reg, Register base, int32_t offset)
+{
+    // [base + disp32] addressing, where a base of rsp or r12 requires a SIB byte
+    EmitByte(0x80 | ((reg & 7) << 3) | (base & 7));
+    if((base & 7) == 4)
+    {
+        EmitByte(0x24);
+    }
+    EmitInt32(offset);
+}
+
+//
+// JitRowMajInputUnroll
+//
+
+// upper bound on the size of the generated code, larger shapes use the fallback
+const size_t maxJitCodeSize = 1 << 20;
+
+// generates the machine code of an unroll function, which receives X in rdi and U in rsi (System V calling convention)
+static std::vector<uint8_t> GenerateRowMajInputUnroll(int elementSize, int wRows, int wCols, int wChls, int vStride, int hStride, int yRows, int yCols)
+{
+    int xCols = (yCols - 1) * hStride + wCols;
+    int copyBytes = wCols * wChls * elementSize;
+    int xRowBytes = xCols * wChls * elementSize;
+    int uRowBytes = wRows * copyBytes;
+
+    X64Emitter emitter;
+    emitter.MovImmediate(X64Emitter::r8, yRows);
+    size_t rowLoop = emitter.Position();
+    emitter.MovImmediate(X64Emitter::r9, yCols);
+    size_t colLoop = emitter.Position();
+
+    // copy the wRows filter rows of one output pixel, in chunks of 16 bytes followed by the remainder
+    for(int wRow = 0; wRow < wRows; ++wRow)
+    {
+        int offset = 0;
+        while(offset < copyBytes)
+        {
+            int remaining = copyBytes - offset;
+            int size = remaining >= 16 ? 16 : remaining >= 8 ? 8 : remaining >= 4 ? 4 : remaining >= 2 ? 2 : 1;
+            emitter.Copy(X64Emitter::rdi, wRow * xRowBytes + offset, X64Emitter::rsi, wRow * copyBytes + offset, size);
+            offset += size;
+        }
+
+        if(emitter.Position() > maxJitCodeSize)
+        {
+            return {};
+        }
+    }
+
+    // advance to the next output pixel
+    emitter.AddImmediate(X64Emitter::rdi, hStride * wChls * elementSize);
+    emitter.AddImmediate(X64Emitter::rsi, uRowBytes);
+    emitter.Decrement(X64Emitter::r9);
+    emitter.JumpIfNotZero(colLoop);
+
+    // advance to the next output row
+    int rowAdjustment = vStride * xRowBytes - yCols * hStride * wChls * elementSize;
+    if(rowAdjustment != 0)
+    {
+        emitter.AddImmediate(X64Emitter::rdi, rowAdjustment);
+    }
+    emitter.Decrement(X64Emitter::r8);
+    emitter.JumpIfNotZero(rowLoop);
+    emitter.Return();
+
+    return emitter.Code();
+}
+
+const JitRowMajInputUnroll* JitRowMajInputUnroll::Get(int elementSize, int wRows, int wCols, int wChls, int vStride, int hStride, int yRows, int yCols)
+{
+#ifdef JIT_AVAILABLE
+    static std::map<std::array<int, 8>, std::unique_ptr<JitRowMajInputUnroll>> cache;
+    static std::mutex mutex;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::array<int, 8> key = { elementSize, wRows, wCols, wChls, vStride, hStride, yRows, yCols };
+    auto iterator = cache.find(key);
+    if(iterator != cache.end())
+    {
+        return iterator->second.get();
+    }
+
+    // all byte offsets must fit in the 32-bit displacements of the generated code
+    int64_t xRows = (int64_t)(yRows - 1) * vStride + wRows;
+    int64_t xCols = (int64_t)(yCols - 1) * hStride + wCols;
+    int64_t xBytes = xRows * xCols * wChls * elementSize;
+    int64_t uBytes = (int64_t)yRows * yCols * wRows * wCols * wChls * elementSize;
+    bool isSupported = yRows > 0 && yCols > 0 && xBytes < INT32_MAX && uBytes < INT32_MAX;
+
+    std::unique_ptr<JitRowMajInputUnroll> function;
+    if(isSupported)
+    {
+        auto code = GenerateRowMajInputUnroll(elementSize, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+        if(!code.empty())
+        {
+            function.reset(new JitRowMajInputUnroll(code));
+            if(function->_function == nullptr)
+            {
+                function.reset();
+            }
+        }
+    }
+
+    // failures are cached too, so that the fallback is chosen without retrying
+    return (cache[key] = std::move(function)).get();
+#else
+    return nullptr;
+#endif
+}
+
+JitRowMajInputUnroll::JitRowMajInputUnroll(const std::vector<uint8_t>& code)
+{
+#ifdef JIT_AVAILABLE
+    // write the code to read-write memory, and then make the memory read-execute
+    void* memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(memory == MAP_FAILED)
+    {
+        return;
+    }
+    _memory = memory;
+    _size = code.size();
+
+    std::copy(code.begin(), code.end(), (uint8_t*)_memory);
+    if(mprotect(_memory, _size, PROT_READ | PROT_EXEC) != 0)
+    {
+        return;
+    }
+    _function = (FunctionType)_memory;
+#endif
+}
+
+JitRowMajInputUnroll::~JitRowMajInputUnroll()
+{
+#ifdef JIT_AVAILABLE
+    if(_memory != nullptr)
+    {
+        munmap(_memory, _size);
+    }
+#endif
+}
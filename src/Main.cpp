@@ -6,17 +6,50 @@
 //
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "AsyncConvolution.h"
+#include "BinaryUnrolledInputConv.h"
+#include "BitPacking.h"
 #include "BlasHelpers.h"
 #include "ConvProperties.h"
 #include "CSVParser.h"
 #include "ForLoopConv.h"
+#include "FusedLayersConv.h"
+#include "HalfPrecision.h"
+#include "IncrementalConv.h"
+#include "JitRowMajInputUnroll.h"
+#include "JitUnrolledInputConv.h"
+#include "LowRankFilters.h"
+#include "Numa.h"
+#include "OutOfCoreConv.h"
 #include "PartiallyUnrolledInputImplicitInPaddingConv.h"
+#include "PipelinedUnrolledInputConv.h"
+#include "ProcessShardedConv.h"
+#include "Quantization.h"
+#include "QuantizedUnrolledInputConv.h"
+#include "ReducedPrecisionUnrolledInputConv.h"
+#include "SeparableFiltersConv.h"
+#include "SmallChannelConv.h"
+#include "SparseFiltersUnrolledInputConv.h"
+#include "SparseMatrix.h"
+#include "SpatiallyTiledUnrolledInputConv.h"
+#include "StreamingConv.h"
 #include "Tensor.h"
 #include "TestHelpers.h"
+#include "ThreadAffinity.h"
+#include "ThreadPool.h"
+#include "ThroughputExecutor.h"
 #include "UnrolledInputConv_cI.h"
 #include "UnrolledInputConv_rI.h"
 #include "UnrolledInputExplicitOutPaddingConv.h"
@@ -25,9 +58,10 @@
 #include "UnrolledOutputConv.h"
 #include "VirtuallyUnrolledInputExplicitOutPaddingConv.h"
 #include "VirtuallyUnrolledInputExplicitPaddingConv.h"
+#include "ZeroSkippingUnrolledInputConv.h"
 
-template <typename TensorType>
-void PrintBenchmark(bool condition, double testDuration, const std::vector<TensorType>& inputs, const BenchmarkType<float>& benchmark)
+template <typename ElementType, int degree, typename BenchmarkFunctionType>
+void PrintBenchmark(bool condition, double testDuration, const std::vector<Tensor<ElementType, degree>>& inputs, const BenchmarkFunctionType& benchmark)
 {
     if(!condition)
     {
@@ -37,7 +71,7 @@ void PrintBenchmark(bool condition, double testDuration, const std::vector<Tenso
 
     try
     {
-        auto time = GetMeanExecutionTime<float>(testDuration, inputs, benchmark);
+        auto time = GetMeanExecutionTime<ElementType>(testDuration, inputs, benchmark);
         std::cout << time;
     }
     catch(...)
@@ -48,8 +82,304 @@ void PrintBenchmark(bool condition, double testDuration, const std::vector<Tenso
     std::cout.flush();
 }
 
-void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+// gets the name of a new file in the temporary directory (given by the TMPDIR or TEMP environment variable, or /tmp), with a
+// random suffix so that concurrent runs do not share files
+std::string GetTemporaryFilename(const std::string& prefix)
 {
+    const char* directory = std::getenv("TMPDIR");
+    if(directory == nullptr)
+    {
+        directory = std::getenv("TEMP");
+    }
+    if(directory == nullptr)
+    {
+        directory = "/tmp";
+    }
+
+    std::random_device device;
+    return std::string(directory) + "/" + prefix + "_" + std::to_string(device()) + ".tmp";
+}
+
+// prints the number of inputs processed per second by a benchmark that processes all of the inputs in one call
+template <typename BenchmarkFunctionType>
+void PrintThroughput(bool condition, double testDuration, int inputCount, const BenchmarkFunctionType& benchmark)
+{
+    if(!condition)
+    {
+        std::cout << "n/a";
+        return;
+    }
+
+    try
+    {
+        // warm up the caches, and then repeat the test until the desired duration is reached
+        benchmark();
+        int repetitions = 0;
+        double duration = 0;
+        auto startTime = std::chrono::high_resolution_clock::now();
+        while(duration < testDuration)
+        {
+            benchmark();
+            ++repetitions;
+            duration = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+        }
+        std::cout << 1000.0 * inputCount * repetitions / duration;
+    }
+    catch(...)
+    {
+        std::cout << "err";
+    }
+
+    std::cout.flush();
+}
+
+// Gets the ratio of the bytes moved by a low-precision unrolled-input convolution to those moved by the float convolution, as a
+// model of its memory traffic: the filters and input are read once, the unrolled input and any intermediate output are written
+// and read once, and the output is written once. The arguments are the element counts of the filters, input, unrolled input and
+// output, and the element sizes in bytes of each (zBytes is the element size of the intermediate output, or 0 if there is none).
+double GetBytesMovedRatio(double wSize, double xSize, double uSize, double ySize, int wBytes, int xBytes, int uBytes, int zBytes, int yBytes)
+{
+    double bytes = wSize * wBytes + xSize * xBytes + 2 * uSize * uBytes + 2 * ySize * zBytes + ySize * yBytes;
+    double floatBytes = (wSize + xSize + 2 * uSize + ySize) * sizeof(float);
+    return bytes / floatBytes;
+}
+
+// runs the unrolled-input convolutions with input and output stored in a 16-bit floating point type, followed by the ratio of
+// the bytes they move to those moved by the float convolutions
+template <typename StorageType>
+void RunReducedPrecisionBenchmarks(double testDuration, const Tensor<float, 4>& WFilMaj, const std::vector<Tensor<float, 3>>& XRowMajExp, const std::vector<Tensor<float, 3>>& XChlMajExp, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride, double relativeTolerance)
+{
+    // convert the inputs to the storage type, which halves their size
+    auto Convert = [](const std::vector<Tensor<float, 3>>& tensors)
+    {
+        std::vector<Tensor<StorageType, 3>> converted;
+        for(const auto& T : tensors)
+        {
+            converted.emplace_back(T.Shape(), T.Order());
+            std::copy(T.Data(), T.Data() + T.Size(), converted.back().Data());
+        }
+        return converted;
+    };
+    auto XRowMajExpH = Convert(XRowMajExp);
+    auto XChlMajExpH = Convert(XChlMajExp);
+
+    // the reference output is a float convolution of the last converted input, rounded to the storage type
+    auto XRef = Tensor<float, 3>(XRowMajExpH.back().Shape(), RowMaj3);
+    std::copy(XRowMajExpH.back().Data(), XRowMajExpH.back().Data() + XRef.Size(), XRef.Data());
+    auto YFloat = Tensor<float, 3>({ yRows, yCols, wCount }, RowMaj3);
+    Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{}, WFilMaj.Data(), XRef.Data(), YFloat.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+    auto YRef = Tensor<StorageType, 3>(YFloat.Shape(), RowMaj3);
+    std::copy(YFloat.Data(), YFloat.Data() + YFloat.Size(), YRef.Data());
+
+    // the two outputs can differ by one unit in the last place of the storage type
+    float maxAbs = 0;
+    std::for_each(YFloat.Data(), YFloat.Data() + YFloat.Size(), [&](float y) { maxAbs = std::max(maxAbs, std::abs(y)); });
+    double tolerance = relativeTolerance * maxAbs;
+
+    auto Y = Tensor<StorageType, 3>(YFloat.Shape(), RowMaj3);
+    std::vector<StorageType> space(wRows * wCols * wChls * yRows * yCols);
+    std::vector<float> panelSpace(GetReducedPrecisionPanelSpaceSize(yRows * yCols, wRows * wCols * wChls, wCount));
+
+    // UnrolledInputConv_rIfFrO with reduced precision storage
+    PrintBenchmark(true, testDuration, XRowMajExpH, [&](const StorageType* X)
+    {
+        auto properties = ConvProperties<FilterMajorFilters, ReducedPrecisionStorage, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+        Convolution(properties, WFilMaj.Data(), X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data(), panelSpace.data());
+    });
+    assert(YRef.ApproxEquals(Y, tolerance));
+    std::cout << ", ";
+
+    // UnrolledInputConv_cIfFrO with reduced precision storage
+    PrintBenchmark(hStride == 1, testDuration, XChlMajExpH, [&](const StorageType* X)
+    {
+        auto properties = ConvProperties<ChannelMajorInput, FilterMajorFilters, ReducedPrecisionStorage, RowMajorOutput, UnitHorizontalStride, UnrolledInput>{};
+        Convolution(properties, WFilMaj.Data(), X, Y.Data(), wCount, wRows, wCols, wChls, vStride, yRows, yCols, space.data(), panelSpace.data());
+    });
+    assert(hStride != 1 || YRef.ApproxEquals(Y, tolerance));
+
+    // the input, unrolled input and output are 16-bit, and the float panels around each matrix multiplication stay in cache
+    std::cout << ", " << GetBytesMovedRatio(WFilMaj.Size(), XRowMajExp[0].Size(), space.size(), Y.Size(), sizeof(float), sizeof(StorageType), sizeof(StorageType), 0, sizeof(StorageType));
+}
+
+// runs the 8-bit quantized convolution, followed by the ratio of the bytes it moves to those moved by the float convolution
+void RunQuantizedBenchmark(double testDuration, const Tensor<float, 4>& WFilMaj, const std::vector<Tensor<float, 3>>& XRowMajExp, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    // quantize the filters with per-channel scales and the inputs with a per-tensor scale
+    int wSize = wRows * wCols * wChls;
+    auto WQ = std::vector<int8_t>(wCount * wSize);
+    auto wScales = std::vector<float>(wCount);
+    QuantizeFilters(WFilMaj.Data(), WQ.data(), wScales.data(), wCount, wSize, true);
+
+    auto xParameters = GetQuantizationParameters(XRowMajExp[0].Data(), XRowMajExp[0].Size(), 0, 255);
+    std::vector<Tensor<uint8_t, 3>> XRowMajExpQ;
+    for(const auto& X : XRowMajExp)
+    {
+        XRowMajExpQ.emplace_back(X.Shape(), RowMaj3);
+        Quantize(X.Data(), XRowMajExpQ.back().Data(), X.Size(), xParameters);
+    }
+
+    // calibrate the output quantization on a float convolution of the dequantized filters and last input
+    auto WDeq = Tensor<float, 4>(WFilMaj.Shape(), WFilMaj.Order());
+    for(int filter = 0; filter < wCount; ++filter)
+    {
+        Dequantize(WQ.data() + filter * wSize, WDeq.Data() + filter * wSize, wSize, {wScales[filter], 0});
+    }
+    auto XDeq = Tensor<float, 3>(XRowMajExpQ.back().Shape(), RowMaj3);
+    Dequantize(XRowMajExpQ.back().Data(), XDeq.Data(), XDeq.Size(), xParameters);
+    auto YFloat = Tensor<float, 3>({ yRows, yCols, wCount }, RowMaj3);
+    Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{}, WDeq.Data(), XDeq.Data(), YFloat.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+    auto yParameters = GetQuantizationParameters(YFloat.Data(), YFloat.Size(), -128, 127);
+    auto YQRef = Tensor<int8_t, 3>(YFloat.Shape(), RowMaj3);
+    Quantize(YFloat.Data(), YQRef.Data(), YFloat.Size(), yParameters);
+
+    auto YQ = Tensor<int8_t, 3>(YFloat.Shape(), RowMaj3);
+    auto spaceQ = std::vector<uint8_t>(wSize * yRows * yCols);
+    auto accumulators = std::vector<int32_t>(yRows * yCols * wCount + wCount);
+    PrintBenchmark(true, testDuration, XRowMajExpQ, [&](const uint8_t* X)
+    {
+        auto properties = ConvProperties<FilterMajorFilters, QuantizedInt8, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+        Convolution(properties, WQ.data(), wScales.data(), X, xParameters, YQ.Data(), yParameters, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, spaceQ.data(), accumulators.data());
+    });
+    assert(YQRef.ApproxEquals(YQ, 1));
+
+    // the filters, input, unrolled input and output are 8-bit, and the output is accumulated in 32-bit integers
+    std::cout << ", " << GetBytesMovedRatio(WFilMaj.Size(), XRowMajExp[0].Size(), spaceQ.size(), YQ.Size(), 1, 1, 1, sizeof(int32_t), 1);
+}
+
+// runs the quantized and reduced-precision benchmarks, which are derived from the float filters and inputs
+void RunLowPrecisionBenchmarks(double testDuration, const Tensor<float, 4>& WFilMaj, const std::vector<Tensor<float, 3>>& XRowMajExp, const std::vector<Tensor<float, 3>>& XChlMajExp, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    // QuantizedUnrolledInputConv_rIfFrO and its bytes moved ratio
+    RunQuantizedBenchmark(testDuration, WFilMaj, XRowMajExp, wCount, wRows, wCols, wChls, yRows, yCols, vStride, hStride);
+    std::cout << ", ";
+
+    // UnrolledInputConv_rIfFrO_Float16, UnrolledInputConv_cIfFrO_Float16 and their bytes moved ratio
+    RunReducedPrecisionBenchmarks<Float16>(testDuration, WFilMaj, XRowMajExp, XChlMajExp, wCount, wRows, wCols, wChls, yRows, yCols, vStride, hStride, 1.0 / 1024);
+    std::cout << ", ";
+
+    // UnrolledInputConv_rIfFrO_BFloat16, UnrolledInputConv_cIfFrO_BFloat16 and their bytes moved ratio
+    RunReducedPrecisionBenchmarks<BFloat16>(testDuration, WFilMaj, XRowMajExp, XChlMajExp, wCount, wRows, wCols, wChls, yRows, yCols, vStride, hStride, 1.0 / 128);
+}
+
+// the quantized and reduced-precision benchmarks do not apply to other element types
+template <typename ElementType>
+void RunLowPrecisionBenchmarks(double, const Tensor<ElementType, 4>&, const std::vector<Tensor<ElementType, 3>>&, const std::vector<Tensor<ElementType, 3>>&, int, int, int, int, int, int, int, int)
+{
+    std::cout << "n/a, n/a, n/a, n/a, n/a, n/a, n/a, n/a";
+}
+
+// runs the binary convolution, on the signs of the filters and inputs
+template <typename ElementType>
+void RunBinaryBenchmark(double testDuration, const Tensor<ElementType, 4>& WFilMaj, const std::vector<Tensor<ElementType, 3>>& XRowMajExp, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    // pack the filters and inputs along the channel dimension
+    int packedChls = GetPackedSize(wChls);
+    auto WPacked = std::vector<uint64_t>(wCount * wRows * wCols * packedChls);
+    PackBits(WFilMaj.Data(), WPacked.data(), wCount * wRows * wCols, wChls);
+
+    std::vector<Tensor<uint64_t, 3>> XRowMajExpPacked;
+    for(const auto& X : XRowMajExp)
+    {
+        XRowMajExpPacked.emplace_back(IntTuple<3>{ X.Size(0), X.Size(1), packedChls }, RowMaj3);
+        PackBits(X.Data(), XRowMajExpPacked.back().Data(), X.Size(0) * X.Size(1), wChls);
+    }
+
+    // the reference output is a convolution of the binarized filters and last input
+    auto WBin = Tensor<ElementType, 4>(WFilMaj.Shape(), WFilMaj.Order());
+    std::transform(WFilMaj.Data(), WFilMaj.Data() + WFilMaj.Size(), WBin.Data(), Binarize<ElementType>);
+    auto XBin = Tensor<ElementType, 3>(XRowMajExp.back().Shape(), RowMaj3);
+    std::transform(XRowMajExp.back().Data(), XRowMajExp.back().Data() + XBin.Size(), XBin.Data(), Binarize<ElementType>);
+    auto YBin = Tensor<ElementType, 3>({ yRows, yCols, wCount }, RowMaj3);
+    Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{}, WBin.Data(), XBin.Data(), YBin.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+    auto YRef = Tensor<int32_t, 3>(YBin.Shape(), RowMaj3);
+    std::transform(YBin.Data(), YBin.Data() + YBin.Size(), YRef.Data(), [](ElementType y) { return (int32_t)std::lround(y); });
+
+    auto Y = Tensor<int32_t, 3>(YBin.Shape(), RowMaj3);
+    auto space = std::vector<uint64_t>(wRows * wCols * packedChls * yRows * yCols);
+    PrintBenchmark(true, testDuration, XRowMajExpPacked, [&](const uint64_t* X)
+    {
+        auto properties = ConvProperties<BitPackedBinary, FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+        Convolution(properties, WPacked.data(), X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
+    });
+    assert(YRef == Y);
+}
+
+// runs the zero-skipping convolution on rectified inputs with dead channels, and prints the fraction of unrolled input elements
+// that it skipped
+template <typename ElementType>
+void RunZeroSkippingBenchmark(double testDuration, const Tensor<ElementType, 4>& WRowMaj, const std::vector<Tensor<ElementType, 3>>& XChlMajExp, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    if(hStride != 1)
+    {
+        std::cout << "n/a, n/a";
+        return;
+    }
+
+    // apply a ReLU to the inputs, which sets about half of their elements to zero, and zero every fourth channel, as in the dead
+    // channels of a trained network (whose ReLU never activates); isolated zeros are rarely skipped, but dead channels and the
+    // zero-padding are
+    std::vector<Tensor<ElementType, 3>> XChlMajExpReLU;
+    for(const auto& X : XChlMajExp)
+    {
+        XChlMajExpReLU.emplace_back(X.Shape(), X.Order());
+        std::transform(X.Data(), X.Data() + X.Size(), XChlMajExpReLU.back().Data(), [](ElementType x) { return std::max(x, ElementType(0)); });
+
+        int channelSize = X.Shape()[0] * X.Shape()[1];
+        for(int xChl = 0; xChl < X.Shape()[2]; xChl += 4)
+        {
+            std::fill(XChlMajExpReLU.back().Data() + xChl * channelSize, XChlMajExpReLU.back().Data() + (xChl + 1) * channelSize, ElementType(0));
+        }
+    }
+
+    // the reference output is the dense unrolled-input convolution of the last rectified input
+    auto YRef = Tensor<ElementType, 3>({ yRows, yCols, wCount }, RowMaj3);
+    std::vector<ElementType> denseSpace(wRows * wCols * wChls * yRows * yCols);
+    auto denseProperties = ConvProperties<ChannelMajorInput, RowMajorFilters, RowMajorOutput, UnitHorizontalStride, UnrolledInput>{};
+    Convolution(denseProperties, WRowMaj.Data(), XChlMajExpReLU.back().Data(), YRef.Data(), wCount, wRows, wCols, wChls, vStride, yRows, yCols, denseSpace.data());
+
+    auto Y = Tensor<ElementType, 3>({ yRows, yCols, wCount }, RowMaj3);
+    std::vector<ElementType> space(wRows * wCols * wChls * (yRows * yCols + wCount));
+    double skippedFraction = 0;
+    PrintBenchmark(true, testDuration, XChlMajExpReLU, [&](const ElementType* X)
+    {
+        auto properties = ConvProperties<ChannelMajorInput, RowMajorFilters, RowMajorOutput, UnitHorizontalStride, UnrolledInput, ZeroSkippingInput>{};
+        Convolution(properties, WRowMaj.Data(), X, Y.Data(), wCount, wRows, wCols, wChls, vStride, yRows, yCols, space.data(), &skippedFraction);
+    });
+    assert(YRef.ApproxEquals(Y, 1.0e-3));
+    std::cout << ", " << skippedFraction;
+}
+
+// runs the separable convolution, with a rank-1 approximation of the filters
+template <typename ElementType>
+void RunSeparableBenchmark(double testDuration, const Tensor<ElementType, 4>& WFilMaj, const std::vector<Tensor<ElementType, 3>>& XRowMajExp, const std::vector<Tensor<ElementType, 3>>& XChlMajExp, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    // a full-rank decomposition reconstructs the filters
+    auto WRec = Tensor<ElementType, 4>(WFilMaj.Shape(), WFilMaj.Order());
+    GetFilterTensor(GetLowRankFilters(WFilMaj.Data(), wCount, wRows, wCols, wChls, 0.0, std::min(wRows, wCols)), WRec.Data());
+    assert(WFilMaj.ApproxEquals(WRec, 1.0e-3));
+
+    // the reference output is a convolution of the reconstructed rank-1 filters
+    auto WLowRank = GetLowRankFilters(WFilMaj.Data(), wCount, wRows, wCols, wChls, 0.0, 1);
+    GetFilterTensor(WLowRank, WRec.Data());
+    auto YRef = Tensor<ElementType, 3>({ yRows, yCols, wCount }, RowMaj3);
+    Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{}, WRec.Data(), XRowMajExp.back().Data(), YRef.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+
+    auto Y = Tensor<ElementType, 3>({ yRows, yCols, wCount }, RowMaj3);
+    int xRows = (yRows - 1) * vStride + wRows;
+    std::vector<ElementType> space(xRows * yCols + yRows * yCols);
+    PrintBenchmark(true, testDuration, XChlMajExp, [&](const ElementType* X)
+    {
+        auto properties = ConvProperties<ChannelMajorInput, RowMajorOutput, SeparableFilters>{};
+        Convolution(properties, WLowRank, X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
+    });
+    assert(YRef.ApproxEquals(Y, 1.0e-3));
+}
+
+template <typename ElementType>
+void RunAllBenchmarks(const std::string& prefix, double testDuration, int xCount, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    std::cout << prefix;
+
     // comparison tolerance (only in Debug compile)
     const double tolerance = 1.0e-3;
 
@@ -74,32 +404,32 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // generate random filters in two memory orders
     engine.seed(seed1);
-    auto WFilMaj = GetRandomTensor<float, 4>(engine, { wCount, wRows, wCols, wChls }, {3, 2, 1, 0});
+    auto WFilMaj = GetRandomTensor<ElementType, 4>(engine, { wCount, wRows, wCols, wChls }, {3, 2, 1, 0});
     engine.seed(seed1);
-    auto WRowMaj = GetRandomTensor<float, 4>(engine, { wCount, wRows, wCols, wChls }, {0, 3, 2, 1});
+    auto WRowMaj = GetRandomTensor<ElementType, 4>(engine, { wCount, wRows, wCols, wChls }, {0, 3, 2, 1});
 
     // generate random input in both row-major and channel-major orders, and with both explicit and implicit zero-padding
     engine.seed(seed2);
-    auto XRowMajExp = GetRandomTensors<float, 3>(xCount, engine, { xRows, xCols, xChls }, RowMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
+    auto XRowMajExp = GetRandomTensors<ElementType, 3>(xCount, engine, { xRows, xCols, xChls }, RowMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
     engine.seed(seed2);
-    auto XChlMajExp = GetRandomTensors<float, 3>(xCount, engine, { xRows, xCols, xChls }, ChlMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
+    auto XChlMajExp = GetRandomTensors<ElementType, 3>(xCount, engine, { xRows, xCols, xChls }, ChlMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
     engine.seed(seed2);
-    auto XRowMajImp = GetRandomTensors<float, 3>(xCount, engine, { yRows, yCols, xChls }, RowMaj3);
+    auto XRowMajImp = GetRandomTensors<ElementType, 3>(xCount, engine, { yRows, yCols, xChls }, RowMaj3);
     engine.seed(seed2);
-    auto XChlMajImp = GetRandomTensors<float, 3>(xCount, engine, { yRows, yCols, xChls }, ChlMaj3);
+    auto XChlMajImp = GetRandomTensors<ElementType, 3>(xCount, engine, { yRows, yCols, xChls }, ChlMaj3);
 
     // allocate output tensors
-    auto YRef = Tensor<float,3>({ yRows, yCols, yChls }, RowMaj3);
-    auto YRowMaj = Tensor<float,3>({ yRows, yCols, yChls }, RowMaj3);
-    auto YRowMajExp = Tensor<float,3>({ xRows, xCols, yChls }, RowMaj3);
-    auto YChlMaj = Tensor<float,3>({ yRows, yCols, yChls }, ChlMaj3);
-    auto YChlMajExp = Tensor<float,3>({ xRows, xCols, yChls }, ChlMaj3);
+    auto YRef = Tensor<ElementType,3>({ yRows, yCols, yChls }, RowMaj3);
+    auto YRowMaj = Tensor<ElementType,3>({ yRows, yCols, yChls }, RowMaj3);
+    auto YRowMajExp = Tensor<ElementType,3>({ xRows, xCols, yChls }, RowMaj3);
+    auto YChlMaj = Tensor<ElementType,3>({ yRows, yCols, yChls }, ChlMaj3);
+    auto YChlMajExp = Tensor<ElementType,3>({ xRows, xCols, yChls }, ChlMaj3);
 
     // scratch space
-    std::vector<float> space;
+    NumaVector<ElementType> space;
 
     // ForLoopConv
-    PrintBenchmark(true, testDuration, XRowMajExp, [&](const float* X)
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{};
         Convolution(properties, WFilMaj.Data(), X, YRef.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
@@ -108,7 +438,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputConv_rIrFrO
     space.resize(wRows * wCols * wChls * yRows * yCols);
-    PrintBenchmark(true, testDuration, XRowMajExp, [&](const float* X)
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<RowMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
         Convolution(properties, WRowMaj.Data(), X, YRowMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
@@ -118,7 +448,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputConv_rIrFcO
     space.resize(wRows * wCols * wChls * yRows * yCols);
-    PrintBenchmark(true, testDuration, XRowMajExp, [&](const float* X)
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<RowMajorFilters, RowMajorInput, ChannelMajorOutput, UnrolledInput>{};
         Convolution(properties, WRowMaj.Data(), X, YChlMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
@@ -128,7 +458,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputConv_rIfFrO
     space.resize(wRows * wCols * wChls * yRows * yCols);
-    PrintBenchmark(true, testDuration, XRowMajExp, [&](const float* X)
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
         Convolution(properties, WFilMaj.Data(), X, YRowMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
@@ -138,7 +468,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputConv_rIfFcO
     space.resize(wRows * wCols * wChls * yRows * yCols);
-    PrintBenchmark(true, testDuration, XRowMajExp, [&](const float* X)
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, ChannelMajorOutput, UnrolledInput>{};
         Convolution(properties, WFilMaj.Data(), X, YChlMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
@@ -148,7 +478,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputConv_cIrFrO
     space.resize(wRows * wCols * wChls * yRows * yCols);
-    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const float* X)
+    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ChannelMajorInput, RowMajorFilters, RowMajorOutput, UnitHorizontalStride, UnrolledInput>{};
         Convolution(properties, WRowMaj.Data(), X, YRowMaj.Data(), wCount, wRows, wCols, wChls, vStride, yRows, yCols, space.data());
@@ -158,7 +488,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputConv_cIrFcO
     space.resize(wRows * wCols * wChls * yRows * yCols);
-    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const float* X)
+    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ChannelMajorInput, RowMajorFilters, ChannelMajorOutput, UnitHorizontalStride, UnrolledInput>{};
         Convolution(properties, WRowMaj.Data(), X, YChlMaj.Data(), wCount, wRows, wCols, wChls, vStride, yRows, yCols, space.data());
@@ -168,7 +498,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputConv_cIfFrO
     space.resize(wRows * wCols * wChls * yRows * yCols);
-    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const float* X)
+    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ChannelMajorInput, FilterMajorFilters, RowMajorOutput, UnitHorizontalStride, UnrolledInput>{};
         Convolution(properties, WFilMaj.Data(), X, YRowMaj.Data(), wCount, wRows, wCols, wChls, vStride, yRows, yCols, space.data());
@@ -178,7 +508,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputConv_cIfFcO
     space.resize(wRows * wCols * wChls * yRows * yCols);
-    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const float* X)
+    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ChannelMajorInput, FilterMajorFilters, ChannelMajorOutput, UnitHorizontalStride, UnrolledInput>{};
         Convolution(properties, WFilMaj.Data(), X, YChlMaj.Data(), wCount, wRows, wCols, wChls, vStride, yRows, yCols, space.data());
@@ -188,7 +518,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledOutputConv
     space.resize(xRows * xCols * wCount * wRows * wCols);
-    PrintBenchmark(hStride == 1, testDuration, XRowMajExp, [&](const float* X)
+    PrintBenchmark(hStride == 1, testDuration, XRowMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ChannelMajorOutput, FilterMajorFilters, RowMajorInput, UnrolledOutput>{};
         Convolution(properties, WFilMaj.Data(), X, YChlMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
@@ -198,7 +528,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputImplicitInPaddingConv
     space.resize(9 * wChls * yRows * yCols);
-    PrintBenchmark(wRows == 3 && wCols == 3 && vStride == 1 && hStride == 1, testDuration, XChlMajImp, [&](const float* X)
+    PrintBenchmark(wRows == 3 && wCols == 3 && vStride == 1 && hStride == 1, testDuration, XChlMajImp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ChannelMajorInput, FilterMajorFilters, ImplicitInputPadding, RowMajorOutput, ThreeByThreeField, UnitHorizontalStride, UnitVerticalStride, UnrolledInput>{};
         Convolution(properties, WFilMaj.Data(), X, YRowMaj.Data(), wCount, wChls, yRows, yCols, space.data());
@@ -208,7 +538,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputExplicitOutPaddingConv
     space.resize((yRows * yCols + (yRows - 1) * (wCols - 1)) * wRows * wCols * wChls);
-    PrintBenchmark(vStride == 1 && hStride == 1, testDuration, XChlMajExp, [&](const float* X)
+    PrintBenchmark(vStride == 1 && hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ChannelMajorInput, ExplicitOutputPadding, FilterMajorFilters, OddField, RowMajorOutput, UnitHorizontalStride, UnitVerticalStride, UnrolledInput>{};
         Convolution(properties, WFilMaj.Data(), X, YRowMajExp.Data(), wCount, wRows, wCols, wChls, yRows, yCols, space.data());
@@ -218,7 +548,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // UnrolledInputExplicitPaddingConv
     space.resize((yRows * yCols + (yRows - 1) * (wCols - 1)) * wRows * wCols * wChls);
-    PrintBenchmark(vStride == 1 && hStride == 1, testDuration, XChlMajExp, [&](const float* X)
+    PrintBenchmark(vStride == 1 && hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ChannelMajorInput, ExplicitInputPadding, ExplicitOutputPadding, FilterMajorFilters, OddField, RowMajorOutput, UnitHorizontalStride, UnitVerticalStride, UnrolledInput>{};
         Convolution(properties, WFilMaj.Data(), X, YRowMajExp.Data(), wCount, wRows, wCols, wChls, yRows, yCols, xPadTop, xPadLeft, space.data());
@@ -228,7 +558,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
 
     // PartiallyUnrolledInputImplicitInPaddingConv
     space.resize(yRows * yCols * wChls);
-    PrintBenchmark(wRows == 3 && wCols == 3 && vStride == 1 && hStride == 1, testDuration, XRowMajImp, [&](const float* X)
+    PrintBenchmark(wRows == 3 && wCols == 3 && vStride == 1 && hStride == 1, testDuration, XRowMajImp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ImplicitInputPadding, PartiallyUnrolledInput, RowMajorFilters, RowMajorInput, RowMajorOutput, ThreeByThreeField, UnitHorizontalStride, UnitVerticalStride>{};
         Convolution(properties, WRowMaj.Data(), X, YRowMaj.Data(), wCount, wChls, yRows, yCols, space.data());
@@ -237,7 +567,7 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
     std::cout << ", ";
 
     // VirtuallyUnrolledInputExplicitOutPaddingConv
-    PrintBenchmark(vStride == 1 && hStride == 1, testDuration, XRowMajExp, [&](const float* X)
+    PrintBenchmark(vStride == 1 && hStride == 1, testDuration, XRowMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<ExplicitOutputPadding, OddField, RowMajorFilters, RowMajorInput, RowMajorOutput, UnitHorizontalStride, UnitVerticalStride, VirtuallyUnrolledInput>{};
         Convolution(properties, WRowMaj.Data(), X, YRowMajExp.Data(), wCount, wRows, wCols, wChls, yRows, yCols);
@@ -246,16 +576,696 @@ void RunAllBenchmarks(double testDuration, int xCount, int wCount, int wRows, in
     std::cout << ", ";
 
     // VirtuallyUnrolledInputExplicitPaddingConv
-    PrintBenchmark(vStride == 1 && hStride == 1, testDuration, XRowMajExp, [&](const float* X)
+    PrintBenchmark(vStride == 1 && hStride == 1, testDuration, XRowMajExp, [&](const ElementType* X)
     {
         auto properties = ConvProperties<RowMajorInput, ExplicitInputPadding, ExplicitOutputPadding, OddField, RowMajorFilters, RowMajorOutput, UnitHorizontalStride, UnitVerticalStride, VirtuallyUnrolledInput>{};
         Convolution(properties, WRowMaj.Data(), X, YRowMajExp.Data(), wCount, wRows, wCols, wChls, yRows, yCols, xPadTop, xPadLeft);
     });
     assert(YRef.ApproxEquals(YRowMajExp.GetSubTensor({1,1,0}, YRef.Shape()), tolerance));
+    std::cout << ", ";
+
+    // quantized and reduced-precision variants
+    RunLowPrecisionBenchmarks(testDuration, WFilMaj, XRowMajExp, XChlMajExp, wCount, wRows, wCols, wChls, yRows, yCols, vStride, hStride);
+    std::cout << ", ";
+
+    // BinaryUnrolledInputConv_rIfFrO
+    RunBinaryBenchmark(testDuration, WFilMaj, XRowMajExp, wCount, wRows, wCols, wChls, yRows, yCols, vStride, hStride);
+    std::cout << ", ";
+
+    // ZeroSkippingUnrolledInputConv_cIrFrO and its skipped fraction
+    RunZeroSkippingBenchmark(testDuration, WRowMaj, XChlMajExp, wCount, wRows, wCols, wChls, yRows, yCols, vStride, hStride);
+    std::cout << ", ";
+
+    // SeparableFiltersConv_cIrO_rank1
+    RunSeparableBenchmark(testDuration, WFilMaj, XRowMajExp, XChlMajExp, wCount, wRows, wCols, wChls, yRows, yCols, vStride, hStride);
+    std::cout << ", ";
+
+    // SmallChannelConv_rIrFrO
+    space.resize(wRows * wCols * wChls * (wCount + smallChannelFilterBlock));
+    PrintBenchmark(wChls <= 4, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        auto properties = ConvProperties<RowMajorFilters, RowMajorInput, RowMajorOutput, SmallChannelCount>{};
+        Convolution(properties, WRowMaj.Data(), X, YRowMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
+    });
+    assert(wChls > 4 || YRef.ApproxEquals(YRowMaj, tolerance));
+    std::cout << ", ";
+
+    // RowMajInputUnroll_generic and RowMajInputUnroll_specialized, which time only the single-threaded unrolling step
+    int uRows = yRows * yCols;
+    int uCols = wRows * wCols * wChls;
+    space.resize(uRows * uCols);
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        RowMajInputUnrollGeneric(X, space.data(), wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+    });
+    std::cout << ", ";
+
+    NumaVector<ElementType> specializedSpace(uRows * uCols);
+    PrintBenchmark(IsRowMajInputUnrollSpecialized(wRows, wCols, vStride, hStride), testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        RowMajInputUnrollSerial(X, specializedSpace.data(), wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+    });
+    assert(space == specializedSpace || !IsRowMajInputUnrollSpecialized(wRows, wCols, vStride, hStride));
+    std::cout << ", ";
+
+    // RowMajInputUnroll_parallel, which unrolls on the shared thread pool
+    NumaVector<ElementType> parallelSpace(uRows * uCols);
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        RowMajInputUnroll(X, parallelSpace.data(), wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+    });
+    assert(space == parallelSpace);
+    std::cout << ", ";
+
+    // ChlMajInputUnroll_serial and ChlMajInputUnroll_parallel
+    NumaVector<ElementType> chlMajSpace(uRows * uCols);
+    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
+    {
+        ChlMajInputUnrollBlock(X, chlMajSpace.data(), wRows, wCols, wChls, vStride, yRows, yCols, uRows, uCols, 0, uCols, 0, yRows);
+    });
+    std::cout << ", ";
+
+    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
+    {
+        ChlMajInputUnroll(X, parallelSpace.data(), wRows, wCols, wChls, vStride, yRows, yCols, uRows, uCols);
+    });
+    assert(hStride != 1 || chlMajSpace == parallelSpace);
+    std::cout << ", ";
+
+    // RowMajInputUnroll_jit
+    bool isJitAvailable = JitRowMajInputUnroll::Get((int)sizeof(ElementType), wRows, wCols, wChls, vStride, hStride, yRows, yCols) != nullptr;
+    NumaVector<ElementType> jitSpace(uRows * uCols);
+    PrintBenchmark(isJitAvailable, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        JitRowMajInputUnrollOrFallback(X, jitSpace.data(), wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+    });
+    assert(space == jitSpace || !isJitAvailable);
+    std::cout << ", ";
+
+    // JitUnrolledInputConv_rIfFrO
+    PrintBenchmark(isJitAvailable, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        auto properties = ConvProperties<FilterMajorFilters, JitCompiledUnroll, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+        Convolution(properties, WFilMaj.Data(), X, YRowMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, jitSpace.data());
+    });
+    assert(!isJitAvailable || YRef.ApproxEquals(YRowMaj, tolerance));
+    std::cout << ", ";
+
+    // SpatiallyTiledUnrolledInputConv_rIfFrO
+    int bandRows = GetSpatialTilingBandRows(wRows, wCols, wChls, yRows, yCols, (int)sizeof(ElementType));
+    space.resize(uCols * bandRows * yCols * GetSpatialTilingSliceCount(yRows, bandRows));
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, SpatialTiling, UnrolledInput>{};
+        Convolution(properties, WFilMaj.Data(), X, YRowMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, bandRows, space.data());
+    });
+    assert(YRef.ApproxEquals(YRowMaj, tolerance));
+    std::cout << ", ";
+
+    // PipelinedUnrolledInputConv_rIfFrO, followed by the fraction of the unroll time that overlapped matrix multiplication
+    int chunkRows = GetPipelineChunkRows(yRows);
+    space.resize(uRows * uCols);
+    PipelineStatistics statistics;
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        auto properties = ConvProperties<FilterMajorFilters, PipelinedUnroll, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+        Convolution(properties, WFilMaj.Data(), X, YRowMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, chunkRows, space.data(), &statistics);
+    });
+    assert(YRef.ApproxEquals(YRowMaj, tolerance));
+    std::cout << ", " << statistics.GetOverlap() << ", ";
+
+    // ProcessShardedUnrolledInputConv_rIfFrO, with one worker process per NUMA node (at least two), including the time to copy
+    // each input into shared memory and the output out of it
+    try
+    {
+        ProcessShardedConvolution<ElementType> sharded(std::max(2, GetNumaNodeCount()), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+        std::copy(WFilMaj.Data(), WFilMaj.Data() + WFilMaj.Size(), sharded.GetFilters());
+        PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+        {
+            std::copy(X, X + XRowMajExp[0].Size(), sharded.GetInput());
+            sharded.Run();
+            std::copy(sharded.GetOutput(), sharded.GetOutput() + YRowMaj.Size(), YRowMaj.Data());
+        });
+        assert(YRef.ApproxEquals(YRowMaj, tolerance));
+    }
+    catch(...)
+    {
+        std::cout << "err";
+    }
+    std::cout << ", ";
+
+    // StreamingConv_rIfFrO, which pushes the input one row at a time and writes each output row as soon as it is computed
+    StreamingConvolution<ElementType> streaming(WFilMaj.Data(), wCount, wRows, wCols, wChls, vStride, hStride, xCols);
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        streaming.Reset();
+        for(int xRow = 0; xRow < xRows; ++xRow)
+        {
+            streaming.PushRow(X + xRow * xCols * xChls, YRowMaj.Data() + streaming.GetOutputRowCount() * yCols * wCount);
+        }
+    });
+    assert(YRef.ApproxEquals(YRowMaj, tolerance));
+    std::cout << ", ";
+
+    // OutOfCoreUnrolledInputConv_rIfFrO, which convolves the last input from a file into a file in four tiles, followed by the
+    // fraction of the time that the computation waited for I/O
+    const std::string inputFilename = GetTemporaryFilename("convolutional_outofcore_input");
+    const std::string outputFilename = GetTemporaryFilename("convolutional_outofcore_output");
+    int tileRows = (yRows + 3) / 4;
+    space.resize(uCols * tileRows * yCols);
+    try
+    {
+        std::ofstream inputFile(inputFilename, std::ios::binary);
+        inputFile.write(reinterpret_cast<const char*>(XRowMajExp.back().Data()), XRowMajExp.back().Size() * sizeof(ElementType));
+        inputFile.close();
+        if(!inputFile)
+        {
+            throw std::runtime_error("cannot write the input file " + inputFilename);
+        }
+
+        OutOfCoreStatistics outOfCoreStatistics;
+        auto time = GetMeanExecutionTime<ElementType>(testDuration, XRowMajExp, [&](const ElementType*)
+        {
+            auto properties = ConvProperties<OutOfCore, RowMajorInput, RowMajorOutput>{};
+            Convolution<ElementType>(properties, inputFilename, outputFilename, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, tileRows, [&](const ElementType* X, ElementType* Y, int tileYRows)
+            {
+                auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+                Convolution(properties, WFilMaj.Data(), X, Y, wCount, wRows, wCols, wChls, vStride, hStride, tileYRows, yCols, space.data());
+            }, &outOfCoreStatistics);
+        });
+
+        std::ifstream outputFile(outputFilename, std::ios::binary);
+        if(!outputFile.read(reinterpret_cast<char*>(YRowMaj.Data()), YRowMaj.Size() * sizeof(ElementType)))
+        {
+            throw std::runtime_error("cannot read the output file " + outputFilename);
+        }
+        assert(YRef.ApproxEquals(YRowMaj, tolerance));
+        std::cout << time << ", " << outOfCoreStatistics.ioWaitTime / outOfCoreStatistics.totalTime;
+    }
+    catch(...)
+    {
+        std::cout << "err, err";
+    }
+    std::remove(inputFilename.c_str());
+    std::remove(outputFilename.c_str());
+    std::cout << ", ";
+
+    // IncrementalConv_rIfFrO, which updates the output of the last input after a change to a centered rectangle of an eighth of
+    // its rows and columns, followed by the fraction of the output that was recomputed
+    std::vector<ElementType> XChanged(XRowMajExp.back().Data(), XRowMajExp.back().Data() + XRowMajExp.back().Size());
+    TensorRectangle changed = { xRows * 7 / 16, xCols * 7 / 16, std::max(1, xRows / 8), std::max(1, xCols / 8) };
+    for(int row = changed.row; row < changed.row + changed.rows; ++row)
+    {
+        for(int element = changed.col * xChls; element < (changed.col + changed.cols) * xChls; ++element)
+        {
+            XChanged[row * xCols * xChls + element] += 1;
+        }
+    }
+    auto YChangedRef = Tensor<ElementType,3>({ yRows, yCols, yChls }, RowMaj3);
+    Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{}, WFilMaj.Data(), XChanged.data(), YChangedRef.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+
+    std::copy(YRef.Data(), YRef.Data() + YRef.Size(), YRowMaj.Data());
+    NumaVector<ElementType> incrementalSpace(xRows * xCols * xChls + yRows * yCols * yChls);
+    space.resize(uRows * uCols);
+    double recomputedFraction = 0;
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType*)
+    {
+        auto properties = ConvProperties<IncrementalUpdate, RowMajorInput, RowMajorOutput>{};
+        Convolution(properties, XChanged.data(), YRowMaj.Data(), { changed }, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, [&](const ElementType* X, ElementType* Y, int rectangleYRows, int rectangleYCols)
+        {
+            auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+            Convolution(properties, WFilMaj.Data(), X, Y, wCount, wRows, wCols, wChls, vStride, hStride, rectangleYRows, rectangleYCols, space.data());
+        }, incrementalSpace.data(), &recomputedFraction);
+    });
+    assert(YChangedRef.ApproxEquals(YRowMaj, tolerance));
+    std::cout << ", " << recomputedFraction << std::endl;
+}
+
+// runs the dense and sparse-filter convolutions, with the filters pruned to increasing levels of sparsity
+template <typename ElementType>
+void RunSparsityBenchmarks(const std::string& prefix, double testDuration, int xCount, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    // comparison tolerance (only in Debug compile)
+    const double tolerance = 1.0e-3;
+
+    // input shape
+    int xRows = (yRows - 1) * vStride + wRows; // includes any input padding
+    int xCols = (yCols - 1) * hStride + wCols; // includes any input padding
+    int xChls = wChls;
+
+    // input padding 
+    int xPadTop = (wRows - 1) / 2;
+    int xPadBottom = wRows - 1 - xPadTop;
+    int xPadLeft = (wCols - 1) / 2;
+    int xPadRight = wCols - 1 - xPadLeft; 
+
+    // random seeds and engine
+    std::seed_seq seed1 = {103, 311, 1283};
+    std::seed_seq seed2 = {3929, 437, 859};
+    std::default_random_engine engine;
+
+    // generate random filters and inputs
+    engine.seed(seed1);
+    auto WFilMaj = GetRandomTensor<ElementType, 4>(engine, { wCount, wRows, wCols, wChls }, {3, 2, 1, 0});
+    engine.seed(seed2);
+    auto XRowMajExp = GetRandomTensors<ElementType, 3>(xCount, engine, { xRows, xCols, xChls }, RowMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
+
+    // allocate output tensors and scratch space
+    auto YRef = Tensor<ElementType,3>({ yRows, yCols, wCount }, RowMaj3);
+    auto Y = Tensor<ElementType,3>({ yRows, yCols, wCount }, RowMaj3);
+    int wSize = wRows * wCols * wChls;
+    NumaVector<ElementType> space(wSize * yRows * yCols);
+
+    // the filter-major weights tensor is a column-major matrix with one row per filter element and one column per filter
+    auto GetPrunedFilters = [&](int blockRows, int blockCols, double sparsity)
+    {
+        std::vector<ElementType> W(WFilMaj.Data(), WFilMaj.Data() + WFilMaj.Size());
+        PruneBlocks(W.data(), wSize, wCount, ColMaj, blockRows, blockCols, sparsity);
+        return W;
+    };
+
+    // computes the reference output of the pruned filters
+    auto ComputeReference = [&](const std::vector<ElementType>& W)
+    {
+        auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{};
+        Convolution(properties, W.data(), XRowMajExp.back().Data(), YRef.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+    };
+
+    for(double sparsity : { 0.0, 0.5, 0.7, 0.8, 0.9, 0.95 })
+    {
+        std::cout << prefix << sparsity << ", ";
+
+        // UnrolledInputConv_rIfFrO and SparseFiltersUnrolledInputConv_CSR, with unstructured pruning
+        auto W = GetPrunedFilters(1, 1, sparsity);
+        ComputeReference(W);
+        PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+            Convolution(properties, W.data(), X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
+        });
+        assert(YRef.ApproxEquals(Y, tolerance));
+        std::cout << ", ";
+
+        auto WCsr = GetCsrMatrix(W.data(), wSize, wCount, ColMaj);
+        PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<RowMajorInput, RowMajorOutput, SparseFilters, UnrolledInput>{};
+            Convolution(properties, WCsr, X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
+        });
+        assert(YRef.ApproxEquals(Y, tolerance));
+        std::cout << ", ";
+
+        // SparseFiltersUnrolledInputConv_BSR1x4, with blocks of one filter element in four consecutive filters
+        W = GetPrunedFilters(1, 4, sparsity);
+        ComputeReference(W);
+        auto W1x4 = GetBlockSparseMatrix<1, 4>(W.data(), wSize, wCount, ColMaj);
+        PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<RowMajorInput, RowMajorOutput, SparseFilters, UnrolledInput>{};
+            Convolution(properties, W1x4, X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
+        });
+        assert(YRef.ApproxEquals(Y, tolerance));
+        std::cout << ", ";
+
+        // SparseFiltersUnrolledInputConv_BSR4x4, with blocks of four consecutive filter elements in four consecutive filters
+        W = GetPrunedFilters(4, 4, sparsity);
+        ComputeReference(W);
+        auto W4x4 = GetBlockSparseMatrix<4, 4>(W.data(), wSize, wCount, ColMaj);
+        PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<RowMajorInput, RowMajorOutput, SparseFilters, UnrolledInput>{};
+            Convolution(properties, W4x4, X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
+        });
+        assert(YRef.ApproxEquals(Y, tolerance));
+        std::cout << std::endl;
+    }
+}
+
+// runs the unrolled-input convolutions one input at a time with multi-threaded BLAS (latency, in ms per input), and on all
+// of the inputs concurrently with single-threaded BLAS (throughput, in inputs per second)
+template <typename ElementType>
+void RunThroughputBenchmarks(const std::string& prefix, double testDuration, int xCount, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    std::cout << prefix << ThreadPool::GetShared().GetThreadCount() << ", ";
+
+    // comparison tolerance (only in Debug compile)
+    const double tolerance = 1.0e-3;
+
+    // input shape
+    int xRows = (yRows - 1) * vStride + wRows; // includes any input padding
+    int xCols = (yCols - 1) * hStride + wCols; // includes any input padding
+    int xChls = wChls;
+
+    // input padding 
+    int xPadTop = (wRows - 1) / 2;
+    int xPadBottom = wRows - 1 - xPadTop;
+    int xPadLeft = (wCols - 1) / 2;
+    int xPadRight = wCols - 1 - xPadLeft; 
+
+    // random seeds and engine
+    std::seed_seq seed1 = {103, 311, 1283};
+    std::seed_seq seed2 = {3929, 437, 859};
+    std::default_random_engine engine;
+
+    // generate random filters and inputs
+    engine.seed(seed1);
+    auto WFilMaj = GetRandomTensor<ElementType, 4>(engine, { wCount, wRows, wCols, wChls }, {3, 2, 1, 0});
+    engine.seed(seed2);
+    auto XRowMajExp = GetRandomTensors<ElementType, 3>(xCount, engine, { xRows, xCols, xChls }, RowMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
+    engine.seed(seed2);
+    auto XChlMajExp = GetRandomTensors<ElementType, 3>(xCount, engine, { xRows, xCols, xChls }, ChlMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
+
+    // compute the reference output of the last input
+    auto YRef = Tensor<ElementType,3>({ yRows, yCols, wCount }, RowMaj3);
+    Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{}, WFilMaj.Data(), XRowMajExp.back().Data(), YRef.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+
+    // one output per input, and one slice of temporary space per concurrent input; neither is written here, so that with the
+    // "local" NUMA policy their pages are placed by the threads that first write them
+    int spaceSize = wRows * wCols * wChls * yRows * yCols;
+    NumaVector<ElementType> space(spaceSize * GetConcurrentSliceCount(xCount));
+    auto Y = Tensor<ElementType,3>({ yRows, yCols, wCount }, RowMaj3);
+    std::vector<NumaVector<ElementType>> outputs(xCount);
+    for(auto& output : outputs)
+    {
+        output.resize(Y.Size());
+    }
+
+    std::vector<const ElementType*> rowMajInputs;
+    std::vector<const ElementType*> chlMajInputs;
+    std::vector<ElementType*> outputPointers;
+    for(int i = 0; i < xCount; ++i)
+    {
+        rowMajInputs.push_back(XRowMajExp[i].Data());
+        chlMajInputs.push_back(XChlMajExp[i].Data());
+        outputPointers.push_back(outputs[i].data());
+    }
+
+    // checks the output of the last input against the reference (only in Debug compile)
+    #ifndef NDEBUG
+    auto IsLastOutputCorrect = [&]()
+    {
+        std::copy(outputs.back().begin(), outputs.back().end(), Y.Data());
+        return YRef.ApproxEquals(Y, tolerance);
+    };
+    #endif
+
+    // UnrolledInputConv_rIfFrO
+    auto rowMajConvolution = [&](const ElementType* X, ElementType* output, ElementType* slice)
+    {
+        auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+        Convolution(properties, WFilMaj.Data(), X, output, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, slice);
+    };
+
+    PrintBenchmark(true, testDuration, XRowMajExp, [&](const ElementType* X)
+    {
+        rowMajConvolution(X, Y.Data(), space.data());
+    });
+    assert(YRef.ApproxEquals(Y, tolerance));
+    std::cout << ", ";
+
+    PrintThroughput(true, testDuration, xCount, [&]()
+    {
+        RunConcurrently(rowMajInputs.data(), outputPointers.data(), xCount, space.data(), spaceSize, rowMajConvolution);
+    });
+    assert(IsLastOutputCorrect());
+    std::cout << ", ";
+
+    // UnrolledInputConv_rIfFrO submitted asynchronously, with one future and one block of temporary space per input, and single-threaded BLAS
+    NumaVector<ElementType> asyncSpace(spaceSize * xCount);
+    std::vector<std::future<void>> futures(xCount);
+    PrintThroughput(true, testDuration, xCount, [&]()
+    {
+        for(int i = 0; i < xCount; ++i)
+        {
+            auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+            futures[i] = ConvolutionAsync(properties, WFilMaj.Data(), rowMajInputs[i], outputPointers[i], wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, asyncSpace.data() + i * spaceSize);
+        }
+        for(auto& future : futures)
+        {
+            future.get();
+        }
+    });
+    assert(IsLastOutputCorrect());
+    std::cout << ", ";
+
+    // PipelinedUnrolledInputConv_rIfFrO on the entire batch, which unrolls the next input while the current input is multiplied,
+    // followed by the fraction of the unroll time that overlapped matrix multiplication
+    int chunkRows = GetPipelineChunkRows(yRows);
+    NumaVector<ElementType> pipelineSpace(spaceSize * std::min(xCount, 2));
+    PipelineStatistics statistics;
+    PrintThroughput(true, testDuration, xCount, [&]()
+    {
+        auto properties = ConvProperties<FilterMajorFilters, PipelinedUnroll, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+        Convolution(properties, WFilMaj.Data(), rowMajInputs.data(), outputPointers.data(), xCount, wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, chunkRows, pipelineSpace.data(), &statistics);
+    });
+    assert(IsLastOutputCorrect());
+    std::cout << ", " << statistics.GetOverlap() << ", ";
+
+    // UnrolledInputConv_cIfFrO
+    auto chlMajConvolution = [&](const ElementType* X, ElementType* output, ElementType* slice)
+    {
+        auto properties = ConvProperties<ChannelMajorInput, FilterMajorFilters, RowMajorOutput, UnitHorizontalStride, UnrolledInput>{};
+        Convolution(properties, WFilMaj.Data(), X, output, wCount, wRows, wCols, wChls, vStride, yRows, yCols, slice);
+    };
+
+    PrintBenchmark(hStride == 1, testDuration, XChlMajExp, [&](const ElementType* X)
+    {
+        chlMajConvolution(X, Y.Data(), space.data());
+    });
+    assert(hStride != 1 || YRef.ApproxEquals(Y, tolerance));
+    std::cout << ", ";
+
+    PrintThroughput(hStride == 1, testDuration, xCount, [&]()
+    {
+        RunConcurrently(chlMajInputs.data(), outputPointers.data(), xCount, space.data(), spaceSize, chlMajConvolution);
+    });
+    assert(hStride != 1 || IsLastOutputCorrect());
     std::cout << std::endl;
 }
 
-void ProcessBenchmarksFile(CSVParser<int>& parser)
+// runs the parallel variants with an increasing number of threads (in both the shared thread pool and BLAS), and prints the time,
+// the speedup over one thread and the parallel efficiency (speedup divided by the number of threads) of each variant
+template <typename ElementType>
+void RunThreadScalingBenchmarks(const std::string& prefix, double testDuration, int xCount, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    // comparison tolerance (only in Debug compile)
+    const double tolerance = 1.0e-3;
+
+    // input shape
+    int xRows = (yRows - 1) * vStride + wRows; // includes any input padding
+    int xCols = (yCols - 1) * hStride + wCols; // includes any input padding
+    int xChls = wChls;
+
+    // input padding 
+    int xPadTop = (wRows - 1) / 2;
+    int xPadBottom = wRows - 1 - xPadTop;
+    int xPadLeft = (wCols - 1) / 2;
+    int xPadRight = wCols - 1 - xPadLeft; 
+
+    // random seeds and engine
+    std::seed_seq seed1 = {103, 311, 1283};
+    std::seed_seq seed2 = {3929, 437, 859};
+    std::default_random_engine engine;
+
+    // generate random filters and inputs
+    engine.seed(seed1);
+    auto WFilMaj = GetRandomTensor<ElementType, 4>(engine, { wCount, wRows, wCols, wChls }, {3, 2, 1, 0});
+    engine.seed(seed2);
+    auto XRowMajExp = GetRandomTensors<ElementType, 3>(xCount, engine, { xRows, xCols, xChls }, RowMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
+    engine.seed(seed2);
+    auto XChlMajExp = GetRandomTensors<ElementType, 3>(xCount, engine, { xRows, xCols, xChls }, ChlMaj3, {xPadTop, xPadLeft, 0}, {xPadBottom, xPadRight, 0});
+
+    // compute the reference output of the last input
+    auto YRef = Tensor<ElementType,3>({ yRows, yCols, wCount }, RowMaj3);
+    Convolution(ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput>{}, WFilMaj.Data(), XRowMajExp.back().Data(), YRef.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols);
+    auto Y = Tensor<ElementType,3>({ yRows, yCols, wCount }, RowMaj3);
+
+    int uRows = yRows * yCols;
+    int uCols = wRows * wCols * wChls;
+    NumaVector<ElementType> space;
+    int tiledBandRows = 0;
+
+    // the variants, each with the condition under which it applies, the inputs it reads and a function that checks its output
+    struct Variant
+    {
+        bool condition;
+        const std::vector<Tensor<ElementType, 3>>& inputs;
+        BenchmarkType<ElementType> benchmark;
+        std::function<bool()> isCorrect;
+    };
+
+    auto isOutputCorrect = [&]() { return YRef.ApproxEquals(Y, tolerance); };
+    std::vector<Variant> variants = 
+    {
+        // RowMajInputUnroll (unrolling step only)
+        { true, XRowMajExp, [&](const ElementType* X)
+        {
+            RowMajInputUnroll(X, space.data(), wRows, wCols, wChls, vStride, hStride, yRows, yCols, uRows, uCols);
+        }, [](){ return true; } },
+
+        // UnrolledInputConv_rIfFrO
+        { true, XRowMajExp, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+            Convolution(properties, WFilMaj.Data(), X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, space.data());
+        }, isOutputCorrect },
+
+        // UnrolledInputConv_cIfFrO
+        { hStride == 1, XChlMajExp, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<ChannelMajorInput, FilterMajorFilters, RowMajorOutput, UnitHorizontalStride, UnrolledInput>{};
+            Convolution(properties, WFilMaj.Data(), X, Y.Data(), wCount, wRows, wCols, wChls, vStride, yRows, yCols, space.data());
+        }, isOutputCorrect },
+
+        // SpatiallyTiledUnrolledInputConv_rIfFrO
+        { true, XRowMajExp, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, SpatialTiling, UnrolledInput>{};
+            Convolution(properties, WFilMaj.Data(), X, Y.Data(), wCount, wRows, wCols, wChls, vStride, hStride, yRows, yCols, tiledBandRows, space.data());
+        }, isOutputCorrect }
+    };
+
+    // thread counts 1, 2, 4, ..., up to the number of hardware threads
+    int maxThreadCount = std::max(1, (int)std::thread::hardware_concurrency());
+    std::vector<int> threadCounts;
+    for(int threadCount = 1; threadCount < maxThreadCount; threadCount *= 2)
+    {
+        threadCounts.push_back(threadCount);
+    }
+    threadCounts.push_back(maxThreadCount);
+
+    int blasThreadCount = GetBlasThreadCount();
+    std::vector<double> singleThreadTimes(variants.size());
+    for(int threadCount : threadCounts)
+    {
+        ThreadPool::SetSharedThreadCount(threadCount);
+        SetBlasThreadCount(threadCount);
+
+        // size the temporary space for all of the variants before timing them, since the number of bands that the spatially tiled
+        // convolution processes at once depends on the number of threads
+        tiledBandRows = GetSpatialTilingBandRows(wRows, wCols, wChls, yRows, yCols, (int)sizeof(ElementType));
+        space.resize(std::max(uRows, tiledBandRows * yCols * GetSpatialTilingSliceCount(yRows, tiledBandRows)) * uCols);
+
+        std::cout << prefix << threadCount;
+        for(size_t i = 0; i < variants.size(); ++i)
+        {
+            std::cout << ", ";
+            if(!variants[i].condition)
+            {
+                std::cout << "n/a, n/a, n/a";
+                continue;
+            }
+
+            try
+            {
+                double time = GetMeanExecutionTime<ElementType>(testDuration, variants[i].inputs, variants[i].benchmark);
+                assert(variants[i].isCorrect());
+                if(threadCount == 1)
+                {
+                    singleThreadTimes[i] = time;
+                }
+                double speedup = singleThreadTimes[i] / time;
+                std::cout << time << ", " << speedup << ", " << speedup / threadCount;
+            }
+            catch(...)
+            {
+                std::cout << "err, err, err";
+            }
+            std::cout.flush();
+        }
+        std::cout << std::endl;
+    }
+
+    ThreadPool::SetSharedThreadCount(maxThreadCount);
+    SetBlasThreadCount(blasThreadCount);
+}
+
+// number of layers in the chains run by the fusion benchmarks
+const int fusionChainLength = 3;
+
+// runs a chain of layers one layer at a time and fused, and prints the time of each, the speedup of fusion, and the modeled DRAM
+// traffic of each. The first layer has the benchmark's filter shape and strides, and the following layers have wCount channels and
+// unit strides, so the last layer's output has the benchmark's output shape. A band height of 0 means that fusion would recompute
+// too many halo rows or would not cut the modeled traffic, and the fused convolution runs the chain one layer at a time.
+template <typename ElementType>
+void RunFusionBenchmarks(const std::string& prefix, double testDuration, int xCount, int wCount, int wRows, int wCols, int wChls, int yRows, int yCols, int vStride, int hStride)
+{
+    // comparison tolerance (only in Debug compile)
+    const double tolerance = 1.0e-3;
+
+    // random seeds and engine
+    std::seed_seq seed1 = {103, 311, 1283};
+    std::seed_seq seed2 = {3929, 437, 859};
+    std::default_random_engine engine;
+
+    // generate random filters for each layer
+    engine.seed(seed1);
+    std::vector<Tensor<ElementType, 4>> filters;
+    std::vector<ConvLayer<ElementType>> layers;
+    for(int l = 0; l < fusionChainLength; ++l)
+    {
+        int chls = l == 0 ? wChls : wCount;
+        filters.push_back(GetRandomTensor<ElementType, 4>(engine, { wCount, wRows, wCols, chls }, {3, 2, 1, 0}));
+    }
+    for(int l = 0; l < fusionChainLength; ++l)
+    {
+        layers.push_back({ filters[l].Data(), wCount, wRows, wCols, l == 0 ? wChls : wCount, l == 0 ? vStride : 1, l == 0 ? hStride : 1 });
+    }
+
+    // the input shape that produces the benchmark's output shape at the end of the chain
+    int xRows = yRows;
+    int xCols = yCols;
+    for(int l = fusionChainLength - 1; l >= 0; --l)
+    {
+        xRows = (xRows - 1) * layers[l].vStride + wRows;
+        xCols = (xCols - 1) * layers[l].hStride + wCols;
+    }
+
+    engine.seed(seed2);
+    auto XRowMaj = GetRandomTensors<ElementType, 3>(xCount, engine, { xRows, xCols, wChls }, RowMaj3);
+    auto YRef = Tensor<ElementType, 3>({ yRows, yCols, wCount }, RowMaj3);
+    auto Y = Tensor<ElementType, 3>({ yRows, yCols, wCount }, RowMaj3);
+
+    int bandRows = GetFusedBandRows(layers, xRows, xCols);
+    NumaVector<ElementType> layerByLayerSpace(GetLayerByLayerSpaceSize(layers, xRows, xCols));
+    NumaVector<ElementType> fusedSpace(GetFusedSpaceSize(layers, xRows, xCols, bandRows));
+
+    std::cout << prefix << fusionChainLength << ", ";
+    try
+    {
+        // LayerByLayer
+        double layerByLayerTime = GetMeanExecutionTime<ElementType>(testDuration, XRowMaj, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<FilterMajorFilters, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+            Convolution(properties, layers, X, YRef.Data(), xRows, xCols, layerByLayerSpace.data());
+        });
+
+        // Fused
+        double fusedTime = GetMeanExecutionTime<ElementType>(testDuration, XRowMaj, [&](const ElementType* X)
+        {
+            auto properties = ConvProperties<FilterMajorFilters, FusedLayers, RowMajorInput, RowMajorOutput, UnrolledInput>{};
+            Convolution(properties, layers, X, Y.Data(), xRows, xCols, bandRows, fusedSpace.data());
+        });
+        assert(YRef.ApproxEquals(Y, tolerance));
+
+        auto layerByLayerTraffic = GetLayerByLayerTraffic(layers, xRows, xCols);
+        auto fusedTraffic = GetFusedTraffic(layers, xRows, xCols, bandRows);
+        std::cout << layerByLayerTime << ", " << fusedTime << ", " << layerByLayerTime / fusedTime << ", " << bandRows << ", "
+            << layerByLayerTraffic.bytes / (1 << 20) << ", " << fusedTraffic.bytes / (1 << 20) << ", " << fusedTraffic.recomputedFraction;
+    }
+    catch(...)
+    {
+        std::cout << "err, err, err, err, err, err, err";
+    }
+    std::cout << std::endl;
+}
+
+// the benchmark modes
+enum class BenchmarkMode { all, fusion, sparsity, threadScaling, throughput };
+
+// prints the output header, and runs the benchmarks on each set of parameters in the benchmarks file
+template <typename RunBenchmarksType>
+void ProcessBenchmarksFile(CSVParser<int>& parser, const std::vector<std::string>& columns, const RunBenchmarksType& runBenchmarks)
 {
     std::vector<std::string> requiredKeys = {"wCount", "wRows", "wCols", "wChls", "yRows", "yCols", "vStride", "hStride"};
     if(!parser.HeaderContains(requiredKeys))
@@ -270,22 +1280,10 @@ void ProcessBenchmarksFile(CSVParser<int>& parser)
         std::cout << key << ", ";
     }
 
-    std::cout << "ForLoopConv, ";
-    std::cout << "UnrolledInputConv_rIrFrO, ";
-    std::cout << "UnrolledInputConv_rIrFcO, ";
-    std::cout << "UnrolledInputConv_rIfFrO, ";
-    std::cout << "UnrolledInputConv_rIfFcO, ";
-    std::cout << "UnrolledInputConv_cIrFrO, ";
-    std::cout << "UnrolledInputConv_cIrFcO, ";
-    std::cout << "UnrolledInputConv_cIfFrO, ";
-    std::cout << "UnrolledInputConv_cIfFcO, ";
-    std::cout << "UnrolledOutputConv, ";
-    std::cout << "UnrolledInputImplicitInPaddingConv, ";
-    std::cout << "UnrolledInputExplicitOutPaddingConv, ";
-    std::cout << "UnrolledInputExplicitPaddingConv, ";
-    std::cout << "PartiallyUnrolledInputImplicitInPaddingConv, ";
-    std::cout << "VirtuallyUnrolledInputExplicitOutPaddingConv, ";
-    std::cout << "VirtuallyUnrolledInputExplicitPaddingConv";
+    for(size_t i = 0; i < columns.size(); ++i)
+    {
+        std::cout << columns[i] << (i + 1 < columns.size() ? ", " : "");
+    }
     std::cout << std::endl;
 
     // run benchmarks
@@ -297,14 +1295,15 @@ void ProcessBenchmarksFile(CSVParser<int>& parser)
         while(parser.IsValid())
         {
             auto parameters = parser[requiredKeys];
+            std::ostringstream prefix;
             for(auto p : parameters)
             {
-                std::cout << p << ", ";
+                prefix << p << ", ";
             }
             
             try
             {
-                RunAllBenchmarks(testDuration, xCount, parser["wCount"], parser["wRows"], parser["wCols"], parser["wChls"], parser["yRows"], parser["yCols"], parser["vStride"], parser["hStride"]);
+                runBenchmarks(prefix.str(), testDuration, xCount, parser["wCount"], parser["wRows"], parser["wCols"], parser["wChls"], parser["yRows"], parser["yCols"], parser["vStride"], parser["hStride"]);
             }
             catch(...)
             {
@@ -320,39 +1319,242 @@ void ProcessBenchmarksFile(CSVParser<int>& parser)
     }
 }
 
+template <typename ElementType>
+void ProcessBenchmarksFile(CSVParser<int>& parser, BenchmarkMode mode)
+{
+    if(mode == BenchmarkMode::fusion)
+    {
+        std::vector<std::string> columns = 
+        {
+            "layers",
+            "LayerByLayer",
+            "Fused",
+            "Fused_speedup",
+            "Fused_bandRows",
+            "LayerByLayer_trafficMB",
+            "Fused_trafficMB",
+            "Fused_recomputedFraction"
+        };
+        ProcessBenchmarksFile(parser, columns, RunFusionBenchmarks<ElementType>);
+        return;
+    }
+
+    if(mode == BenchmarkMode::sparsity)
+    {
+        std::vector<std::string> columns = 
+        {
+            "sparsity",
+            "UnrolledInputConv_rIfFrO",
+            "SparseFiltersUnrolledInputConv_CSR",
+            "SparseFiltersUnrolledInputConv_BSR1x4",
+            "SparseFiltersUnrolledInputConv_BSR4x4"
+        };
+        ProcessBenchmarksFile(parser, columns, RunSparsityBenchmarks<ElementType>);
+        return;
+    }
+
+    if(mode == BenchmarkMode::threadScaling)
+    {
+        std::vector<std::string> columns = { "threads" };
+        for(std::string variant : { "RowMajInputUnroll", "UnrolledInputConv_rIfFrO", "UnrolledInputConv_cIfFrO", "SpatiallyTiledUnrolledInputConv_rIfFrO" })
+        {
+            columns.push_back(variant);
+            columns.push_back(variant + "_speedup");
+            columns.push_back(variant + "_efficiency");
+        }
+        ProcessBenchmarksFile(parser, columns, RunThreadScalingBenchmarks<ElementType>);
+        return;
+    }
+
+    if(mode == BenchmarkMode::throughput)
+    {
+        std::vector<std::string> columns = 
+        {
+            "threads",
+            "UnrolledInputConv_rIfFrO_latency",
+            "UnrolledInputConv_rIfFrO_imagesPerSecond",
+            "UnrolledInputConv_rIfFrO_asyncImagesPerSecond",
+            "PipelinedUnrolledInputConv_rIfFrO_imagesPerSecond",
+            "PipelinedUnrolledInputConv_rIfFrO_overlap",
+            "UnrolledInputConv_cIfFrO_latency",
+            "UnrolledInputConv_cIfFrO_imagesPerSecond"
+        };
+        ProcessBenchmarksFile(parser, columns, RunThroughputBenchmarks<ElementType>);
+        return;
+    }
+
+    std::vector<std::string> columns = 
+    {
+        "ForLoopConv",
+        "UnrolledInputConv_rIrFrO",
+        "UnrolledInputConv_rIrFcO",
+        "UnrolledInputConv_rIfFrO",
+        "UnrolledInputConv_rIfFcO",
+        "UnrolledInputConv_cIrFrO",
+        "UnrolledInputConv_cIrFcO",
+        "UnrolledInputConv_cIfFrO",
+        "UnrolledInputConv_cIfFcO",
+        "UnrolledOutputConv",
+        "UnrolledInputImplicitInPaddingConv",
+        "UnrolledInputExplicitOutPaddingConv",
+        "UnrolledInputExplicitPaddingConv",
+        "PartiallyUnrolledInputImplicitInPaddingConv",
+        "VirtuallyUnrolledInputExplicitOutPaddingConv",
+        "VirtuallyUnrolledInputExplicitPaddingConv",
+        "QuantizedUnrolledInputConv_rIfFrO",
+        "QuantizedUnrolledInputConv_rIfFrO_bytesMovedRatio",
+        "UnrolledInputConv_rIfFrO_Float16",
+        "UnrolledInputConv_cIfFrO_Float16",
+        "UnrolledInputConv_Float16_bytesMovedRatio",
+        "UnrolledInputConv_rIfFrO_BFloat16",
+        "UnrolledInputConv_cIfFrO_BFloat16",
+        "UnrolledInputConv_BFloat16_bytesMovedRatio",
+        "BinaryUnrolledInputConv_rIfFrO",
+        "ZeroSkippingUnrolledInputConv_cIrFrO",
+        "ZeroSkippingUnrolledInputConv_cIrFrO_skippedFraction",
+        "SeparableFiltersConv_cIrO_rank1",
+        "SmallChannelConv_rIrFrO",
+        "RowMajInputUnroll_generic",
+        "RowMajInputUnroll_specialized",
+        "RowMajInputUnroll_parallel",
+        "ChlMajInputUnroll_serial",
+        "ChlMajInputUnroll_parallel",
+        "RowMajInputUnroll_jit",
+        "JitUnrolledInputConv_rIfFrO",
+        "SpatiallyTiledUnrolledInputConv_rIfFrO",
+        "PipelinedUnrolledInputConv_rIfFrO",
+        "PipelinedUnrolledInputConv_rIfFrO_overlap",
+        "ProcessShardedUnrolledInputConv_rIfFrO",
+        "StreamingConv_rIfFrO",
+        "OutOfCoreUnrolledInputConv_rIfFrO",
+        "OutOfCoreUnrolledInputConv_rIfFrO_ioWaitFraction",
+        "IncrementalConv_rIfFrO",
+        "IncrementalConv_rIfFrO_recomputedFraction"
+    };
+    ProcessBenchmarksFile(parser, columns, RunAllBenchmarks<ElementType>);
+}
+
 #ifndef BLAS_VERSION
 #define BLAS_VERSION "none"
 #endif
 
 int main(int argc, char** argv)
 {
-    if(argc != 2)
+    const char* usage = "usage: convolutional [-d] [-n local|interleave] [-p compact|scatter|physical] [-f | -s | -t | -x] <benchmark.csv> (or) convolutional -b\n"
+        "  -d: use double precision elements (default is single precision)\n"
+        "  -f: compare the time and modeled memory traffic of a chain of layers run one layer at a time and fused in bands\n"
+        "  -n: place the pages of tensors and temporary space on the node of the first thread that touches them (local) or\n"
+        "      spread them over all NUMA nodes (interleave), instead of the system default\n"
+        "  -p: pin the threads to logical processors that fill one core at a time (compact), spread over sockets and cores\n"
+        "      (scatter), or use one hyperthread per physical core (physical)\n"
+        "  -s: compare dense and sparse filters over a sweep of filter sparsity levels\n"
+        "  -t: sweep the number of threads (1, 2, 4, ..., all hardware threads) and report the speedup and parallel efficiency\n"
+        "  -x: compare the latency of one input at a time with the throughput (images per second) of concurrent inputs\n";
+
+    // parse the command line
+    std::string filename;
+    bool useDouble = false;
+    auto affinityPolicy = AffinityPolicy::none;
+    auto mode = BenchmarkMode::all;
+    for(int i = 1; i < argc; ++i)
     {
-        std::cout << "usage: convolutional <benchmark.csv> (or) convolutional -b\n";
-        exit(1);
+        std::string argument = argv[i];
+        if(argument == "-b")
+        {
+            std::cout << "Blas version: " << BLAS_VERSION << std::endl; 
+            std::cout << "Threads: " << ThreadPool::GetShared().GetThreadCount() << std::endl;
+            std::cout << "NUMA nodes: " << GetNumaNodeCount() << std::endl;
+            exit(0);
+        }
+        else if(argument == "-d")
+        {
+            useDouble = true;
+        }
+        else if(argument == "-f")
+        {
+            mode = BenchmarkMode::fusion;
+        }
+        else if(argument == "-s")
+        {
+            mode = BenchmarkMode::sparsity;
+        }
+        else if(argument == "-n" && i + 1 < argc)
+        {
+            NumaPolicy policy;
+            if(!ParseNumaPolicy(argv[++i], policy))
+            {
+                std::cout << usage;
+                exit(1);
+            }
+            SetNumaPolicy(policy);
+        }
+        else if(argument == "-p" && i + 1 < argc)
+        {
+            if(!ParseAffinityPolicy(argv[++i], affinityPolicy))
+            {
+                std::cout << usage;
+                exit(1);
+            }
+        }
+        else if(argument == "-t")
+        {
+            mode = BenchmarkMode::threadScaling;
+        }
+        else if(argument == "-x")
+        {
+            mode = BenchmarkMode::throughput;
+        }
+        else if(filename.empty() && argument[0] != '-')
+        {
+            filename = argument;
+        }
+        else
+        {
+            std::cout << usage;
+            exit(1);
+        }
     }
 
-    if(std::string(argv[1]) == "-b")
+    if(filename.empty())
     {
-        std::cout << "Blas version: " << BLAS_VERSION << std::endl; 
-        exit(0);
+        std::cout << usage;
+        exit(1);
     }
 
     #ifndef NDEBUG
     std::cout << "Warning: DEBUG BUILD" << std::endl;
     #endif 
 
+    // pin the threads of the shared thread pool, and report the processor of each thread
+    if(affinityPolicy != AffinityPolicy::none)
+    {
+        auto& threadPool = ThreadPool::GetShared();
+        bool isPinned = threadPool.SetAffinity(affinityPolicy);
+        std::cout << "Threads: " << threadPool.GetThreadCount() << ", affinity: " << GetAffinityPolicyName(affinityPolicy) << (isPinned ? ", cpus:" : " (not supported)");
+        for(int cpu : threadPool.GetAffinityCpus())
+        {
+            std::cout << " " << cpu;
+        }
+        std::cout << std::endl;
+    }
+
     // create a parser for the benchmarks.csv file
-    auto parser = CSVParser<int>(argv[1]);
+    auto parser = CSVParser<int>(filename);
 
     if(!parser.IsValid())
     {
-        std::cout << "error opening and parsing file " << argv[1] << std::endl;
+        std::cout << "error opening and parsing file " << filename << std::endl;
         exit(1);
     }
     
-    ProcessBenchmarksFile(parser);
+    if(useDouble)
+    {
+        ProcessBenchmarksFile<double>(parser, mode);
+    }
+    else
+    {
+        ProcessBenchmarksFile<float>(parser, mode);
+    }
 
     return 0;
 }
-
@@ -0,0 +1,201 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     Numa.cpp
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Numa.h"
+
+// stl
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define NUMA_AVAILABLE
+#endif
+
+static std::atomic<NumaPolicy> currentPolicy(NumaPolicy::systemDefault);
+
+#ifdef NUMA_AVAILABLE
+
+// memory policy modes of the mbind system call (from linux/mempolicy.h, which is not always installed)
+const int mpolInterleave = 3;
+const int mpolLocal = 4;
+
+// the nodemask of mbind is limited to the nodes that fit in one word
+const int maxNumaNodes = 64;
+
+// parses a list of integer ranges in the Linux sysfs format, such as "0-3,8-11"
+static std::vector<int> ParseRangeList(const std::string& text)
+{
+    std::vector<int> values;
+    std::istringstream stream(text);
+    std::string range;
+    while(std::getline(stream, range, ','))
+    {
+        if(range.empty() || range[0] < '0' || range[0] > '9')
+        {
+            continue;
+        }
+
+        auto dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for(int value = first; value <= last; ++value)
+        {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+static std::string ReadLine(const std::string& path)
+{
+    std::ifstream file(path);
+    std::string line;
+    std::getline(file, line);
+    return line;
+}
+
+// gets the cpus of each node, read once from sysfs
+static const std::vector<std::vector<int>>& GetNodeCpus()
+{
+    static const std::vector<std::vector<int>> nodeCpus = []()
+    {
+        std::vector<std::vector<int>> cpus;
+        auto nodes = ParseRangeList(ReadLine("/sys/devices/system/node/online"));
+        int nodeCount = nodes.empty() ? 1 : std::min(maxNumaNodes, *std::max_element(nodes.begin(), nodes.end()) + 1);
+        for(int node = 0; node < nodeCount; ++node)
+        {
+            cpus.push_back(ParseRangeList(ReadLine("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist")));
+        }
+        return cpus;
+    }();
+    return nodeCpus;
+}
+
+int GetNumaNodeCount()
+{
+    return (int)GetNodeCpus().size();
+}
+
+int GetNumaNodeOfCpu(int cpu)
+{
+    const auto& nodeCpus = GetNodeCpus();
+    for(int node = 0; node < (int)nodeCpus.size(); ++node)
+    {
+        if(std::find(nodeCpus[node].begin(), nodeCpus[node].end(), cpu) != nodeCpus[node].end())
+        {
+            return node;
+        }
+    }
+    return 0;
+}
+
+void* NumaAllocate(size_t size)
+{
+    if(size < minNumaAllocationSize)
+    {
+        return ::operator new(size);
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(data == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+
+    // the policy must be set before the pages are first touched; failures (for example, in a restricted container) leave the
+    // default policy in place
+    auto policy = currentPolicy.load();
+    if(policy == NumaPolicy::interleave)
+    {
+        unsigned long nodeMask = GetNumaNodeCount() >= maxNumaNodes ? ~0UL : (1UL << GetNumaNodeCount()) - 1;
+        syscall(SYS_mbind, data, size, mpolInterleave, &nodeMask, (unsigned long)GetNumaNodeCount() + 1, 0);
+    }
+    else if(policy == NumaPolicy::local)
+    {
+        syscall(SYS_mbind, data, size, mpolLocal, nullptr, 0UL, 0);
+    }
+    return data;
+}
+
+void NumaFree(void* data, size_t size)
+{
+    if(size < minNumaAllocationSize)
+    {
+        ::operator delete(data);
+        return;
+    }
+    munmap(data, size);
+}
+
+#else
+
+int GetNumaNodeCount()
+{
+    return 1;
+}
+
+int GetNumaNodeOfCpu(int)
+{
+    return 0;
+}
+
+void* NumaAllocate(size_t size)
+{
+    return ::operator new(size);
+}
+
+void NumaFree(void* data, size_t)
+{
+    ::operator delete(data);
+}
+
+#endif
+
+NumaPolicy GetNumaPolicy()
+{
+    return currentPolicy;
+}
+
+void SetNumaPolicy(NumaPolicy policy)
+{
+    currentPolicy = policy;
+}
+
+const char* GetNumaPolicyName(NumaPolicy policy)
+{
+    switch(policy)
+    {
+    case NumaPolicy::local:
+        return "local";
+    case NumaPolicy::interleave:
+        return "interleave";
+    default:
+        return "default";
+    }
+}
+
+bool ParseNumaPolicy(const char* name, NumaPolicy& policy)
+{
+    for(auto candidate : { NumaPolicy::systemDefault, NumaPolicy::local, NumaPolicy::interleave })
+    {
+        if(std::strcmp(name, GetNumaPolicyName(candidate)) == 0)
+        {
+            policy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,261 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ProcessSharding.cpp
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ProcessSharding.h"
+#include "Numa.h"
+
+// stl
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#define PROCESS_SHARDING_AVAILABLE
+#endif
+
+#ifdef PROCESS_SHARDING_AVAILABLE
+
+SharedMemoryRegion::SharedMemoryRegion(size_t size) : _data(nullptr), _size(size)
+{
+    // a name that is unique on the host, unlinked immediately after the object is mapped
+    static std::atomic<int> regionCount(0);
+    std::string name = "/convolutional-" + std::to_string(getpid()) + "-" + std::to_string(regionCount++);
+
+    int descriptor = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(descriptor < 0)
+    {
+        throw std::bad_alloc();
+    }
+
+    size_t mappedSize = size > 0 ? size : 1;
+    void* data = MAP_FAILED;
+    if(ftruncate(descriptor, (off_t)mappedSize) == 0)
+    {
+        data = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    close(descriptor);
+    shm_unlink(name.c_str());
+
+    if(data == MAP_FAILED)
+    {
+        throw std::bad_alloc();
+    }
+    _data = data;
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    munmap(_data, _size > 0 ? _size : 1);
+}
+
+// the semaphores that coordinate a worker process group, in shared memory
+struct WorkerControlBlock
+{
+    sem_t done;
+    volatile int isStopping;
+    sem_t start[1]; // one per worker, allocated past the end of the struct
+};
+
+static size_t GetControlBlockSize(int processCount)
+{
+    return sizeof(WorkerControlBlock) + sizeof(sem_t) * (processCount - 1);
+}
+
+// pins the calling process to the processors of the given NUMA node
+static void PinProcessToNumaNode(int node)
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int cpuCount = std::max(1, (int)std::thread::hardware_concurrency());
+    for(int cpu = 0; cpu < cpuCount && cpu < CPU_SETSIZE; ++cpu)
+    {
+        if(GetNumaNodeOfCpu(cpu) == node)
+        {
+            CPU_SET(cpu, &cpus);
+        }
+    }
+    if(CPU_COUNT(&cpus) > 0)
+    {
+        sched_setaffinity(0, sizeof(cpus), &cpus);
+    }
+}
+
+WorkerProcessGroup::WorkerProcessGroup(int processCount, std::function<void(int)> work)
+    : _processCount(std::max(1, processCount)), _work(std::move(work)), _control(GetControlBlockSize(std::max(1, processCount)))
+{
+    auto control = static_cast<WorkerControlBlock*>(_control.Data());
+    control->isStopping = 0;
+    sem_init(&control->done, 1, 0);
+    for(int index = 0; index < _processCount; ++index)
+    {
+        sem_init(&control->start[index], 1, 0);
+    }
+
+    int nodeCount = GetNumaNodeCount();
+    for(int index = 0; index < _processCount; ++index)
+    {
+        pid_t processId = fork();
+        if(processId == 0)
+        {
+            // the worker is killed if the parent process dies, and never returns to the code that forked it
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if(nodeCount > 1)
+            {
+                PinProcessToNumaNode(index % nodeCount);
+            }
+
+            int status = 0;
+            while(true)
+            {
+                while(sem_wait(&control->start[index]) != 0 && errno == EINTR);
+                if(control->isStopping)
+                {
+                    break;
+                }
+
+                try
+                {
+                    _work(index);
+                }
+                catch(...)
+                {
+                    status = 1;
+                    break;
+                }
+                sem_post(&control->done);
+            }
+            _exit(status);
+        }
+
+        if(processId < 0)
+        {
+            _isBroken = true;
+            break;
+        }
+        _processIds.push_back(processId);
+    }
+
+    if(_isBroken)
+    {
+        StopWorkers();
+        throw std::runtime_error("failed to fork worker processes");
+    }
+}
+
+WorkerProcessGroup::~WorkerProcessGroup()
+{
+    StopWorkers();
+}
+
+void WorkerProcessGroup::StopWorkers()
+{
+    auto control = static_cast<WorkerControlBlock*>(_control.Data());
+    control->isStopping = 1;
+    for(size_t index = 0; index < _processIds.size(); ++index)
+    {
+        sem_post(&control->start[index]);
+    }
+
+    for(int processId : _processIds)
+    {
+        waitpid(processId, nullptr, 0);
+    }
+    _processIds.clear();
+}
+
+void WorkerProcessGroup::Run()
+{
+    if(_isBroken)
+    {
+        throw std::runtime_error("a worker process has exited");
+    }
+
+    auto control = static_cast<WorkerControlBlock*>(_control.Data());
+    for(int index = 0; index < _processCount; ++index)
+    {
+        sem_post(&control->start[index]);
+    }
+
+    // wait for the workers, checking periodically that none of them has exited
+    for(int finished = 0; finished < _processCount; )
+    {
+        timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += 100 * 1000 * 1000;
+        if(deadline.tv_nsec >= 1000 * 1000 * 1000)
+        {
+            deadline.tv_nsec -= 1000 * 1000 * 1000;
+            ++deadline.tv_sec;
+        }
+
+        if(sem_timedwait(&control->done, &deadline) == 0)
+        {
+            ++finished;
+            continue;
+        }
+
+        for(int processId : _processIds)
+        {
+            if(waitpid(processId, nullptr, WNOHANG) != 0)
+            {
+                _isBroken = true;
+                throw std::runtime_error("a worker process has exited");
+            }
+        }
+    }
+}
+
+#else
+
+SharedMemoryRegion::SharedMemoryRegion(size_t size) : _data(std::calloc(size > 0 ? size : 1, 1)), _size(size)
+{
+    if(_data == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    std::free(_data);
+}
+
+WorkerProcessGroup::WorkerProcessGroup(int processCount, std::function<void(int)> work)
+    : _processCount(std::max(1, processCount)), _work(std::move(work)), _control(1)
+{}
+
+WorkerProcessGroup::~WorkerProcessGroup()
+{}
+
+void WorkerProcessGroup::StopWorkers()
+{}
+
+void WorkerProcessGroup::Run()
+{
+    for(int index = 0; index < _processCount; ++index)
+    {
+        _work(index);
+    }
+}
+
+#endif
@@ -0,0 +1,178 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ThreadAffinity.cpp
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadAffinity.h"
+
+// stl
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <tuple>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define AFFINITY_AVAILABLE
+#endif
+
+const char* GetAffinityPolicyName(AffinityPolicy policy)
+{
+    switch(policy)
+    {
+    case AffinityPolicy::compact:
+        return "compact";
+    case AffinityPolicy::scatter:
+        return "scatter";
+    case AffinityPolicy::physical:
+        return "physical";
+    default:
+        return "none";
+    }
+}
+
+bool ParseAffinityPolicy(const char* name, AffinityPolicy& policy)
+{
+    for(auto candidate : { AffinityPolicy::none, AffinityPolicy::compact, AffinityPolicy::scatter, AffinityPolicy::physical })
+    {
+        if(std::strcmp(name, GetAffinityPolicyName(candidate)) == 0)
+        {
+            policy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef AFFINITY_AVAILABLE
+
+// the position of a logical processor in the machine topology
+struct CpuLocation
+{
+    int cpu;
+    int package;   // socket
+    int core;      // index of the physical core within its socket
+    int sibling;   // index of the hyperthread within its core
+};
+
+static int ReadTopologyValue(int cpu, const char* name)
+{
+    std::ifstream file("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/" + name);
+    int value = 0;
+    file >> value;
+    return value;
+}
+
+// gets the topology of the processors that the process may run on, read once before any thread is pinned
+static const std::vector<CpuLocation>& GetCpuLocations()
+{
+    static const std::vector<CpuLocation> locations = []()
+    {
+        std::vector<CpuLocation> cpus;
+        cpu_set_t allowed;
+        CPU_ZERO(&allowed);
+        if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        {
+            return cpus;
+        }
+
+        for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if(CPU_ISSET(cpu, &allowed))
+            {
+                cpus.push_back({ cpu, ReadTopologyValue(cpu, "physical_package_id"), ReadTopologyValue(cpu, "core_id"), 0 });
+            }
+        }
+
+        // number the hyperthreads of each core in order of their processor number
+        std::sort(cpus.begin(), cpus.end(), [](const CpuLocation& a, const CpuLocation& b) { return std::tie(a.package, a.core, a.cpu) < std::tie(b.package, b.core, b.cpu); });
+        for(size_t i = 1; i < cpus.size(); ++i)
+        {
+            if(cpus[i].package == cpus[i - 1].package && cpus[i].core == cpus[i - 1].core)
+            {
+                cpus[i].sibling = cpus[i - 1].sibling + 1;
+            }
+        }
+
+        // replace the core identifiers, which need not be contiguous, with the index of the core within its socket
+        int coreIndex = 0;
+        for(size_t i = 0; i < cpus.size(); ++i)
+        {
+            if(i > 0 && cpus[i].package != cpus[i - 1].package)
+            {
+                coreIndex = 0;
+            }
+            else if(i > 0 && cpus[i].core != cpus[i - 1].core)
+            {
+                ++coreIndex;
+            }
+            cpus[i].core = coreIndex;
+        }
+        return cpus;
+    }();
+    return locations;
+}
+
+std::vector<int> GetAffinityCpuOrder(AffinityPolicy policy)
+{
+    auto cpus = GetCpuLocations();
+    if(policy == AffinityPolicy::none)
+    {
+        return {};
+    }
+
+    if(policy == AffinityPolicy::physical)
+    {
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [](const CpuLocation& location) { return location.sibling > 0; }), cpus.end());
+    }
+
+    if(policy == AffinityPolicy::scatter)
+    {
+        std::stable_sort(cpus.begin(), cpus.end(), [](const CpuLocation& a, const CpuLocation& b) { return std::tie(a.sibling, a.core, a.package) < std::tie(b.sibling, b.core, b.package); });
+    }
+
+    std::vector<int> order;
+    for(const auto& location : cpus)
+    {
+        order.push_back(location.cpu);
+    }
+    return order;
+}
+
+long GetCurrentThreadId()
+{
+    return (long)syscall(SYS_gettid);
+}
+
+bool PinThread(long threadId, int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity((pid_t)threadId, sizeof(set), &set) == 0;
+}
+
+#else
+
+std::vector<int> GetAffinityCpuOrder(AffinityPolicy)
+{
+    return {};
+}
+
+long GetCurrentThreadId()
+{
+    return 0;
+}
+
+bool PinThread(long, int)
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,299 @@
+////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//  Project:  convolutional
+//  File:     ThreadPool.cpp
+//  Authors:  Ofer Dekel
+//
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ThreadPool.h"
+
+// stl
+#include <algorithm>
+
+// the state of one parallel loop, which lives on the stack of the thread that started the loop
+struct ThreadPool::Loop
+{
+    const Body2D* body;
+    int rowGrainSize;
+    int colGrainSize;
+    std::atomic<int> pendingTaskCount;
+};
+
+// the pool and deque index of the current thread, if it is a worker
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local int currentDequeIndex = 0;
+
+ThreadPool::ThreadPool(int threadCount) : _startedWorkerCount(0), _queuedTaskCount(0)
+{
+    threadCount = std::max(1, threadCount);
+    for(int i = 0; i < threadCount; ++i)
+    {
+        _deques.emplace_back(new TaskDeque);
+    }
+
+    _workerThreadIds.resize(threadCount);
+    for(int i = 1; i < threadCount; ++i)
+    {
+        _workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+    }
+
+    // wait until every worker has published its thread identifier, which SetAffinity needs
+    while(_startedWorkerCount < threadCount - 1)
+    {
+        std::this_thread::yield();
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _isStopping = true;
+    }
+    _taskAdded.notify_all();
+    for(auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+static std::unique_ptr<ThreadPool>& GetSharedPointer()
+{
+    static std::unique_ptr<ThreadPool> pool(new ThreadPool(std::max(1, (int)std::thread::hardware_concurrency())));
+    return pool;
+}
+
+ThreadPool& ThreadPool::GetShared()
+{
+    return *GetSharedPointer();
+}
+
+void ThreadPool::SetSharedThreadCount(int threadCount)
+{
+    auto& pool = GetSharedPointer();
+    if(pool->GetThreadCount() == threadCount)
+    {
+        return;
+    }
+
+    auto policy = pool->GetAffinityPolicy();
+    pool.reset();
+    pool.reset(new ThreadPool(threadCount));
+    pool->SetAffinity(policy);
+}
+
+bool ThreadPool::SetAffinity(AffinityPolicy policy)
+{
+    _affinityPolicy = policy;
+    _affinityCpus.clear();
+    if(policy == AffinityPolicy::none)
+    {
+        return true;
+    }
+
+    auto cpus = GetAffinityCpuOrder(policy);
+    if(cpus.empty())
+    {
+        return false;
+    }
+
+    bool isSuccessful = true;
+    for(int thread = 0; thread < GetThreadCount(); ++thread)
+    {
+        int cpu = cpus[thread % cpus.size()];
+        long threadId = thread == 0 ? GetCurrentThreadId() : _workerThreadIds[thread];
+        isSuccessful = PinThread(threadId, cpu) && isSuccessful;
+        _affinityCpus.push_back(cpu);
+    }
+    return isSuccessful;
+}
+
+void ThreadPool::ParallelFor(int begin, int end, int grainSize, const std::function<void(int, int)>& body)
+{
+    ParallelFor2D(begin, end, 0, 1, grainSize, 1, [&body](int first, int last, int, int)
+    {
+        body(first, last);
+    });
+}
+
+void ThreadPool::ParallelFor2D(int rowBegin, int rowEnd, int colBegin, int colEnd, int rowGrainSize, int colGrainSize, const Body2D& body)
+{
+    if(rowBegin >= rowEnd || colBegin >= colEnd)
+    {
+        return;
+    }
+
+    // run serially if the pool has no workers or the range is a single grain
+    rowGrainSize = std::max(1, rowGrainSize);
+    colGrainSize = std::max(1, colGrainSize);
+    if(_workers.empty() || (rowEnd - rowBegin <= rowGrainSize && colEnd - colBegin <= colGrainSize))
+    {
+        body(rowBegin, rowEnd, colBegin, colEnd);
+        return;
+    }
+
+    Loop loop;
+    loop.body = &body;
+    loop.rowGrainSize = rowGrainSize;
+    loop.colGrainSize = colGrainSize;
+    loop.pendingTaskCount = 1;
+
+    // run the root task on this thread, and then help with any queued tasks until all tasks of this loop are done
+    int dequeIndex = GetCurrentDequeIndex();
+    RunTask(dequeIndex, { &loop, rowBegin, rowEnd, colBegin, colEnd, nullptr });
+    while(loop.pendingTaskCount > 0)
+    {
+        if(!TryRunTask(dequeIndex))
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::Submit(std::function<void()> function)
+{
+    if(_workers.empty())
+    {
+        function();
+        return;
+    }
+
+    Task task = {};
+    task.function = new std::function<void()>(std::move(function));
+    Push(GetCurrentDequeIndex(), task);
+}
+
+void ThreadPool::WorkerLoop(int index)
+{
+    currentPool = this;
+    currentDequeIndex = index;
+    _workerThreadIds[index] = GetCurrentThreadId();
+    ++_startedWorkerCount;
+
+    while(true)
+    {
+        if(TryRunTask(index))
+        {
+            continue;
+        }
+
+        // a stopping pool exits only after all queued tasks have run
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _taskAdded.wait(lock, [this]() { return _isStopping || _queuedTaskCount > 0; });
+        if(_isStopping && _queuedTaskCount <= 0)
+        {
+            return;
+        }
+    }
+}
+
+int ThreadPool::GetCurrentDequeIndex() const
+{
+    return currentPool == this ? currentDequeIndex : 0;
+}
+
+void ThreadPool::Push(int dequeIndex, const Task& task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_deques[dequeIndex]->mutex);
+        _deques[dequeIndex]->tasks.push_back(task);
+    }
+
+    // the count is incremented before locking, so a worker that is about to sleep either sees it or receives the notification
+    ++_queuedTaskCount;
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _taskAdded.notify_one();
+}
+
+bool ThreadPool::TryPop(int dequeIndex, Task& task)
+{
+    std::lock_guard<std::mutex> lock(_deques[dequeIndex]->mutex);
+    auto& tasks = _deques[dequeIndex]->tasks;
+    if(tasks.empty())
+    {
+        return false;
+    }
+
+    // the owner takes the newest task, which is the smallest and the most likely to be in cache
+    task = tasks.back();
+    tasks.pop_back();
+    --_queuedTaskCount;
+    return true;
+}
+
+bool ThreadPool::TrySteal(int dequeIndex, Task& task)
+{
+    // visit the other deques in order, starting after this thread's own deque
+    int dequeCount = (int)_deques.size();
+    for(int i = 1; i < dequeCount; ++i)
+    {
+        auto& victim = *_deques[(dequeIndex + i) % dequeCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if(!victim.tasks.empty())
+        {
+            // a thief takes the oldest task, which is the largest
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+            --_queuedTaskCount;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::TryRunTask(int dequeIndex)
+{
+    Task task;
+    if(TryPop(dequeIndex, task) || TrySteal(dequeIndex, task))
+    {
+        RunTask(dequeIndex, task);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::RunTask(int dequeIndex, Task task)
+{
+    if(task.function != nullptr)
+    {
+        std::unique_ptr<std::function<void()>> function(task.function);
+        (*function)();
+        return;
+    }
+
+    Loop& loop = *task.loop;
+
+    // split the task along the dimension with more grains, keeping the first half and publishing the second half
+    while(true)
+    {
+        int rowGrains = (task.rowEnd - task.rowBegin + loop.rowGrainSize - 1) / loop.rowGrainSize;
+        int colGrains = (task.colEnd - task.colBegin + loop.colGrainSize - 1) / loop.colGrainSize;
+        if(rowGrains <= 1 && colGrains <= 1)
+        {
+            break;
+        }
+
+        Task half = task;
+        if(rowGrains >= colGrains)
+        {
+            int middle = task.rowBegin + (rowGrains / 2) * loop.rowGrainSize;
+            task.rowEnd = middle;
+            half.rowBegin = middle;
+        }
+        else
+        {
+            int middle = task.colBegin + (colGrains / 2) * loop.colGrainSize;
+            task.colEnd = middle;
+            half.colBegin = middle;
+        }
+
+        ++loop.pendingTaskCount;
+        Push(dequeIndex, half);
+    }
+
+    (*loop.body)(task.rowBegin, task.rowEnd, task.colBegin, task.colEnd);
+    --loop.pendingTaskCount;
+}